@@ -38,7 +38,7 @@ void __debugbreak(); // usually in <intrin.h>
 #define Max(X, Y) (((X) > (Y)) ? (X) : (Y))
 #define Min(X, Y) (((X) < (Y)) ? (X) : (Y))
 
-#define SIMPLE_STRING_SIZE 128
+#define SIMPLE_STRING_SIZE 256
 struct simple_string
 {
     u32 BufferSize = SIMPLE_STRING_SIZE;
@@ -4,6 +4,7 @@
 #include "and_common.h"
 
 #include <cmath> // ldexp, fabs
+#include <emmintrin.h>
 
 // NOTE: pcg-random.org
 
@@ -46,7 +47,7 @@ SeedRandom(random_state *RandomState, u64 InitState, u64 InitSequence = 54u)
     RandomState->State = 0u;
     RandomState->Increment = (InitSequence << 1u) | 1u;
     GetRandomU32(RandomState);
-    RandomState->State += InitSequence;
+    RandomState->State += InitState;
     GetRandomU32(RandomState);
 }
 
@@ -113,24 +114,147 @@ GetRandomF3201()
 // NOTE: Perlin noise
 //
 
-#define STB_PERLIN_IMPLEMENTATION
-#include <stb/stb_perlin.h>
+// NOTE: 2D gradient noise. Every octave hashes lattice points with its own permutation of the cell coordinates,
+// shuffled from the seed, so the octaves don't line up with each other. A lattice point gets one of the 12 gradients
+// of 3D improved Perlin noise with Z dropped, which is what slicing that noise along Z used to come down to, so the
+// values are spread the same way. The lattice repeats every PerlinPermutationCount cells each way.
+#define PerlinPermutationCount 256
+#define PerlinMaxOctaves 8
 
-inline f32
-PerlinSample(f32 X, f32 Y, f32 Z, i32 Seed)
+global_variable u8 PerlinGradientIndices[64] =
+{
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    0, 9, 1, 11,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+};
+global_variable f32 PerlinGradients[12][2] =
 {
-    f32 Result = stb_perlin_noise3_seed(X, Y, Z, 0, 0, 0, Seed);
-    local_persist b32 PrintedOne = false;
-    if (Result < 0.0f && !PrintedOne)
+    { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 },
+    { 1, 0 }, { -1, 0 }, { 1,  0 }, { -1,  0 },
+    { 0, 1 }, { 0, -1 }, { 0,  1 }, {  0, -1 },
+};
+
+struct perlin_noise
+{
+    // NOTE: Twice over, so the permuted X plus Y never needs wrapping
+    u8 Permutations[PerlinMaxOctaves][2 * PerlinPermutationCount];
+    // NOTE: The gradient for every entry of Permutations, looked up with the permuted X plus Y
+    u8 GradientIndices[PerlinMaxOctaves][2 * PerlinPermutationCount];
+};
+
+inline void
+SeedPerlinNoise(perlin_noise *Noise, u64 Seed)
+{
+    random_state Random;
+    SeedRandom(&Random, Seed);
+
+    for (u32 Octave = 0;
+         Octave < PerlinMaxOctaves;
+         ++Octave)
     {
-        /* printf("%f\n", Result); */
-        PrintedOne = true;
+        u8 *Permutation = Noise->Permutations[Octave];
+        for (u32 I = 0;
+             I < PerlinPermutationCount;
+             ++I)
+        {
+            Permutation[I] = (u8) I;
+        }
+
+        // NOTE: Fisher-Yates
+        for (u32 I = PerlinPermutationCount - 1;
+             I > 0;
+             --I)
+        {
+            u32 J = GetBoundedRandomU32(&Random, I + 1);
+            u8 Swap = Permutation[I];
+            Permutation[I] = Permutation[J];
+            Permutation[J] = Swap;
+        }
+
+        for (u32 I = 0;
+             I < 2 * PerlinPermutationCount;
+             ++I)
+        {
+            Permutation[I] = Permutation[I % PerlinPermutationCount];
+            Noise->GradientIndices[Octave][I] = PerlinGradientIndices[Permutation[I] & 63];
+        }
+    }
+}
+
+inline i32
+PerlinFloor(f32 Value)
+{
+    i32 Result = (i32) Value;
+    if (Value < (f32) Result)
+    {
+        Result--;
     }
     return Result;
 }
 
+inline f32 *
+GetPerlinGradient(perlin_noise *Noise, u32 Octave, i32 CellX, i32 CellY)
+{
+    u32 Hash = (Noise->Permutations[Octave][(u32) CellX & (PerlinPermutationCount - 1)] +
+                ((u32) CellY & (PerlinPermutationCount - 1)));
+    f32 *Result = PerlinGradients[Noise->GradientIndices[Octave][Hash]];
+    return Result;
+}
+
+inline f32
+PerlinFade(f32 T)
+{
+    f32 Result = ((T * 6 - 15) * T + 10) * T * T * T;
+    return Result;
+}
+
 inline f32
-PerlinSampleOctaves(f32 X, f32 Y, f32 Lacunarity, f32 Gain, u32 Octaves, i32 Seed)
+PerlinLerp(f32 A, f32 B, f32 T)
+{
+    f32 Result = A + (B - A) * T;
+    return Result;
+}
+
+inline __m128
+PerlinLerp4(__m128 A, __m128 B, __m128 T)
+{
+    __m128 Result = _mm_add_ps(A, _mm_mul_ps(_mm_sub_ps(B, A), T));
+    return Result;
+}
+
+inline f32
+PerlinSample(perlin_noise *Noise, f32 X, f32 Y, u32 Octave)
+{
+    Assert(Octave < PerlinMaxOctaves);
+
+    i32 CellX = PerlinFloor(X);
+    i32 CellY = PerlinFloor(Y);
+    f32 DeltaX0 = X - (f32) CellX;
+    f32 DeltaY0 = Y - (f32) CellY;
+    f32 DeltaX1 = DeltaX0 - 1.0f;
+    f32 DeltaY1 = DeltaY0 - 1.0f;
+
+    f32 *Gradient00 = GetPerlinGradient(Noise, Octave, CellX, CellY);
+    f32 *Gradient01 = GetPerlinGradient(Noise, Octave, CellX, CellY + 1);
+    f32 *Gradient10 = GetPerlinGradient(Noise, Octave, CellX + 1, CellY);
+    f32 *Gradient11 = GetPerlinGradient(Noise, Octave, CellX + 1, CellY + 1);
+    f32 N00 = Gradient00[0] * DeltaX0 + Gradient00[1] * DeltaY0;
+    f32 N01 = Gradient01[0] * DeltaX0 + Gradient01[1] * DeltaY1;
+    f32 N10 = Gradient10[0] * DeltaX1 + Gradient10[1] * DeltaY0;
+    f32 N11 = Gradient11[0] * DeltaX1 + Gradient11[1] * DeltaY1;
+
+    f32 V = PerlinFade(DeltaY0);
+    f32 N0 = PerlinLerp(N00, N01, V);
+    f32 N1 = PerlinLerp(N10, N11, V);
+    f32 Result = PerlinLerp(N0, N1, PerlinFade(DeltaX0));
+    return Result;
+}
+
+inline f32
+PerlinSampleOctaves(perlin_noise *Noise, f32 X, f32 Y, f32 Lacunarity, f32 Gain, u32 Octaves)
 {
     f32 Result = 0.0f;
     f32 Amplitude = 1.0f;
@@ -140,7 +264,7 @@ PerlinSampleOctaves(f32 X, f32 Y, f32 Lacunarity, f32 Gain, u32 Octaves, i32 See
          Octave < Octaves;
          ++Octave)
     {
-        Result += PerlinSample(X * Frequency, Y * Frequency, (f32) Octave, Seed) * Amplitude;
+        Result += PerlinSample(Noise, X * Frequency, Y * Frequency, Octave) * Amplitude;
         Frequency *= Lacunarity;
         Amplitude *= Gain;
     }
@@ -148,108 +272,293 @@ PerlinSampleOctaves(f32 X, f32 Y, f32 Lacunarity, f32 Gain, u32 Octaves, i32 See
     return Result;
 }
 
-inline f32
-PerlinNormalize(f32 Intensity)
+// NOTE: PerlinSampleOctaves for a whole grid of samples, Samples[Y * Width + X] being the one at
+// ((X0 + X) / Period, (Y0 + Y) / Period). Does the same arithmetic in the same order as PerlinSample, so it comes out
+// the same as the scalar path, up to PerlinGridEpsilon should the compiler fuse a multiply and an add in only one of
+// them. X0 + X and Y0 + Y have to be exact, i.e. whole numbers below 2^24.
+//
+// Everything that only depends on the column (the lattice cell, the offset in it and its fade) is worked out once per
+// octave for the whole grid, and the corner gradients once per lattice cell of a row, which at these frequencies many
+// samples share. The dot products and interpolation then run 4 columns at a time with SSE2.
+#define PerlinGridMaxWidth 64
+#define PerlinGridEpsilon 1e-5f
+
+inline void
+PerlinSampleOctavesGrid(perlin_noise *Noise, f32 *Samples, i32 Width, i32 Height, f32 X0, f32 Y0, f32 Period,
+                        f32 Lacunarity, f32 Gain, u32 Octaves)
 {
-    if (Intensity > 1.0f)
+    Assert(Width > 0 && Width <= PerlinGridMaxWidth);
+    Assert(Octaves <= PerlinMaxOctaves);
+
+    i32 PaddedWidth = (Width + 3) & ~3;
+
+    f32 Frequencies[PerlinMaxOctaves];
+    f32 Amplitudes[PerlinMaxOctaves];
+    i32 CellsX[PerlinMaxOctaves][PerlinGridMaxWidth];
+    f32 OffsetsX[PerlinMaxOctaves][PerlinGridMaxWidth];
+    f32 FadesX[PerlinMaxOctaves][PerlinGridMaxWidth];
+
+    f32 Amplitude = 1.0f;
+    f32 Frequency = 1.0f;
+    for (u32 Octave = 0;
+         Octave < Octaves;
+         ++Octave)
     {
-        Intensity = 1.0f;
+        Frequencies[Octave] = Frequency;
+        Amplitudes[Octave] = Amplitude;
+        for (i32 X = 0;
+             X < PaddedWidth;
+             ++X)
+        {
+            // NOTE: The padding columns repeat the last one
+            f32 SampleX = ((X0 + (f32) Min(X, Width - 1)) / Period) * Frequency;
+            i32 Cell = PerlinFloor(SampleX);
+            f32 Offset = SampleX - (f32) Cell;
+            CellsX[Octave][X] = Cell;
+            OffsetsX[Octave][X] = Offset;
+            FadesX[Octave][X] = PerlinFade(Offset);
+        }
+        Frequency *= Lacunarity;
+        Amplitude *= Gain;
     }
-    else if (Intensity < -1.0f)
+
+    f32 Row[PerlinGridMaxWidth];
+    f32 Gradients[4][2][PerlinGridMaxWidth];
+    for (i32 Y = 0;
+         Y < Height;
+         ++Y)
     {
-        Intensity = -1.0f;
-    }
+        for (i32 X = 0;
+             X < PaddedWidth;
+             ++X)
+        {
+            Row[X] = 0.0f;
+        }
 
-    Intensity *= 0.5f;
-    Intensity += 0.5f;
-    
-    return Intensity;
+        for (u32 Octave = 0;
+             Octave < Octaves;
+             ++Octave)
+        {
+            f32 SampleY = ((Y0 + (f32) Y) / Period) * Frequencies[Octave];
+            i32 CellY = PerlinFloor(SampleY);
+            f32 OffsetY = SampleY - (f32) CellY;
+            f32 FadeY = PerlinFade(OffsetY);
+
+            // NOTE: Corners in the order 00, 01, 10, 11, first digit X
+            i32 *CellsXInOctave = CellsX[Octave];
+            f32 *Corners[4] = {};
+            for (i32 X = 0;
+                 X < PaddedWidth;
+                 ++X)
+            {
+                if (X == 0 || CellsXInOctave[X] != CellsXInOctave[X - 1])
+                {
+                    i32 CellX = CellsXInOctave[X];
+                    Corners[0] = GetPerlinGradient(Noise, Octave, CellX, CellY);
+                    Corners[1] = GetPerlinGradient(Noise, Octave, CellX, CellY + 1);
+                    Corners[2] = GetPerlinGradient(Noise, Octave, CellX + 1, CellY);
+                    Corners[3] = GetPerlinGradient(Noise, Octave, CellX + 1, CellY + 1);
+                }
+                for (u32 CornerI = 0;
+                     CornerI < 4;
+                     ++CornerI)
+                {
+                    Gradients[CornerI][0][X] = Corners[CornerI][0];
+                    Gradients[CornerI][1][X] = Corners[CornerI][1];
+                }
+            }
+
+            __m128 One = _mm_set1_ps(1.0f);
+            __m128 DeltaY0 = _mm_set1_ps(OffsetY);
+            __m128 DeltaY1 = _mm_sub_ps(DeltaY0, One);
+            __m128 V = _mm_set1_ps(FadeY);
+            __m128 OctaveAmplitude = _mm_set1_ps(Amplitudes[Octave]);
+            for (i32 X = 0;
+                 X < PaddedWidth;
+                 X += 4)
+            {
+                __m128 DeltaX0 = _mm_loadu_ps(OffsetsX[Octave] + X);
+                __m128 DeltaX1 = _mm_sub_ps(DeltaX0, One);
+                __m128 U = _mm_loadu_ps(FadesX[Octave] + X);
+
+                __m128 N00 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(Gradients[0][0] + X), DeltaX0),
+                                        _mm_mul_ps(_mm_loadu_ps(Gradients[0][1] + X), DeltaY0));
+                __m128 N01 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(Gradients[1][0] + X), DeltaX0),
+                                        _mm_mul_ps(_mm_loadu_ps(Gradients[1][1] + X), DeltaY1));
+                __m128 N10 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(Gradients[2][0] + X), DeltaX1),
+                                        _mm_mul_ps(_mm_loadu_ps(Gradients[2][1] + X), DeltaY0));
+                __m128 N11 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(Gradients[3][0] + X), DeltaX1),
+                                        _mm_mul_ps(_mm_loadu_ps(Gradients[3][1] + X), DeltaY1));
+
+                __m128 N0 = PerlinLerp4(N00, N01, V);
+                __m128 N1 = PerlinLerp4(N10, N11, V);
+                __m128 Noise = PerlinLerp4(N0, N1, U);
+
+                _mm_storeu_ps(Row + X, _mm_add_ps(_mm_loadu_ps(Row + X), _mm_mul_ps(Noise, OctaveAmplitude)));
+            }
+        }
+
+        for (i32 X = 0;
+             X < Width;
+             ++X)
+        {
+            Samples[Y * Width + X] = Row[X];
+        }
+    }
 }
 
-#if 0
-// Nevermind lol
-#define PermutationCount 256
+// NOTE: PerlinSampleOctavesGrid approximated from a coarser lattice, one sample every Spacing tiles each way, with
+// Catmull-Rom interpolation in between. The lattice sits at multiples of Spacing rather than at X0 and Y0, so a tile
+// comes out the same whichever grid it's part of. Only worth it for noise that changes slowly from tile to tile, how
+// far off it is for a given spacing is what PerlinChooseCoarseSpacing measures. Spacing has to be a power of two up to
+// PerlinCoarseMaxSpacing, 1 samples every tile exactly.
+#define PerlinCoarseMaxSpacing 16
+#define PerlinCoarseMaxBandHeight 32
 
-struct perlin_state
+inline i32
+PerlinFloorDivide(i32 Value, i32 Divisor)
 {
-    u64 Seed;
-    random_state RandomState;
-    u8 Permutations[PermutationCount];
-};
+    i32 Result = ((Value < 0) ? (Value - (Divisor - 1)) : Value) / Divisor;
+    return Result;
+}
 
 inline void
-SeedPerlin(perlin_state *PerlinState, u64 Seed)
+PerlinCatmullRomWeights(f32 T, f32 *Weights)
 {
-    PerlinState->Seed = Seed;
-    
+    Weights[0] = 0.5f * ((-T + 2.0f) * T - 1.0f) * T;
+    Weights[1] = 0.5f * ((3.0f * T - 5.0f) * T * T + 2.0f);
+    Weights[2] = 0.5f * ((-3.0f * T + 4.0f) * T + 1.0f) * T;
+    Weights[3] = 0.5f * (T - 1.0f) * T * T;
+}
 
-    SeedRandom(&PerlinState->RandomState, PerlinState->Seed);
-    
-    for (u32 PermutationI = 0;
-         PermutationI < PermutationCount;
-         ++PermutationI)
+inline void
+PerlinSampleOctavesCoarseGrid(perlin_noise *Noise, f32 *Samples, i32 Width, i32 Height, i32 X0, i32 Y0, f32 Period,
+                              f32 Lacunarity, f32 Gain, u32 Octaves, i32 Spacing)
+{
+    Assert(Spacing > 0 && Spacing <= PerlinCoarseMaxSpacing && (Spacing & (Spacing - 1)) == 0);
+    if (Spacing == 1)
     {
-        u8 Permutation = (u8) GetBoundedRandomU32(&PerlinState->RandomState, PermutationCount);
-        PerlinState->Permutations[PermutationI] = Permutation;
-        printf("%d\n", Permutation);
+        PerlinSampleOctavesGrid(Noise, Samples, Width, Height, (f32) X0, (f32) Y0, Period, Lacunarity, Gain, Octaves);
+        return;
     }
 
-    Noop;
-}
+    f32 Weights[PerlinCoarseMaxSpacing][4];
+    for (i32 Step = 0;
+         Step < Spacing;
+         ++Step)
+    {
+        PerlinCatmullRomWeights((f32) Step / (f32) Spacing, Weights[Step]);
+    }
 
-inline vec2
-_PerlinRandomGradient(u8 Permutation)
-{
-    f32 Angle = (f32) Permutation / 128.0f * PI32; // (f32) Permutation / 256.0f * 2.0f * PI32;
+    // NOTE: One lattice point before the first tile and two after the last, for the outer interpolation weights
+    i32 FirstLatticeX = PerlinFloorDivide(X0, Spacing) - 1;
+    i32 LatticeWidth = PerlinFloorDivide(X0 + Width - 1, Spacing) + 2 - FirstLatticeX + 1;
+    Assert(LatticeWidth <= PerlinGridMaxWidth);
 
-    vec2 Result = Vec2(SinF(Angle), CosF(Angle));
-    return Result;
+    f32 Lattice[(PerlinCoarseMaxBandHeight / 2 + 4) * PerlinGridMaxWidth];
+    f32 Column[PerlinGridMaxWidth];
+    for (i32 BandY = 0;
+         BandY < Height;
+         BandY += PerlinCoarseMaxBandHeight)
+    {
+        i32 BandHeight = Min(Height - BandY, PerlinCoarseMaxBandHeight);
+        i32 FirstLatticeY = PerlinFloorDivide(Y0 + BandY, Spacing) - 1;
+        i32 LatticeHeight = PerlinFloorDivide(Y0 + BandY + BandHeight - 1, Spacing) + 2 - FirstLatticeY + 1;
+        PerlinSampleOctavesGrid(Noise, Lattice, LatticeWidth, LatticeHeight, (f32) FirstLatticeX, (f32) FirstLatticeY,
+                                Period / (f32) Spacing, Lacunarity, Gain, Octaves);
+
+        for (i32 Y = BandY;
+             Y < BandY + BandHeight;
+             ++Y)
+        {
+            i32 LatticeY = PerlinFloorDivide(Y0 + Y, Spacing) - FirstLatticeY;
+            f32 *WeightsY = Weights[(Y0 + Y) - (LatticeY + FirstLatticeY) * Spacing];
+            f32 *Rows = Lattice + (LatticeY - 1) * LatticeWidth;
+            for (i32 LatticeX = 0;
+                 LatticeX < LatticeWidth;
+                 ++LatticeX)
+            {
+                Column[LatticeX] = (WeightsY[0] * Rows[LatticeX] +
+                                    WeightsY[1] * Rows[LatticeWidth + LatticeX] +
+                                    WeightsY[2] * Rows[2 * LatticeWidth + LatticeX] +
+                                    WeightsY[3] * Rows[3 * LatticeWidth + LatticeX]);
+            }
+
+            for (i32 X = 0;
+                 X < Width;
+                 ++X)
+            {
+                i32 LatticeX = PerlinFloorDivide(X0 + X, Spacing) - FirstLatticeX;
+                f32 *WeightsX = Weights[(X0 + X) - (LatticeX + FirstLatticeX) * Spacing];
+                f32 *Columns = Column + LatticeX - 1;
+                Samples[Y * Width + X] = (WeightsX[0] * Columns[0] + WeightsX[1] * Columns[1] +
+                                          WeightsX[2] * Columns[2] + WeightsX[3] * Columns[3]);
+            }
+        }
+    }
 }
 
-inline f32
-_PerlinGridDotGradient(perlin_state *PerlinState, i32 iX, i32 iY, f32 X, f32 Y, u8 Seed)
+// NOTE: The biggest spacing PerlinSampleOctavesCoarseGrid stays within MaxError of the exact noise with, measured over
+// a few blocks of tiles spread around the origin. A measurement rather than a guarantee, though with a few thousand
+// cells of the coarsest lattice in it the worst case is unlikely to be much worse.
+inline i32
+PerlinChooseCoarseSpacing(perlin_noise *Noise, f32 Period, f32 Lacunarity, f32 Gain, u32 Octaves, f32 MaxError)
 {
-    u8 Permutation = PerlinState->Permutations[PerlinState->Permutations[iX + Seed] + iY];
-    vec2 Gradient = _PerlinRandomGradient(Permutation);
-
-    f32 dX = X - (f32) iX;
-    f32 dY = Y - (f32) iY;
+    i32 BlockDim = 64;
+    i32 BlockCount = 16;
+    f32 Exact[64 * 64];
+    f32 Coarse[64 * 64];
+
+    i32 Result = 1;
+    for (i32 Spacing = PerlinCoarseMaxSpacing;
+         Spacing > 1 && Result == 1;
+         Spacing /= 2)
+    {
+        f32 Error = 0.0f;
+        for (i32 BlockI = 0;
+             BlockI < BlockCount;
+             ++BlockI)
+        {
+            i32 BlockX = (BlockI % 4 - 2) * 1000 * BlockDim;
+            i32 BlockY = (BlockI / 4 - 2) * 1000 * BlockDim + 17;
+            PerlinSampleOctavesGrid(Noise, Exact, BlockDim, BlockDim, (f32) BlockX, (f32) BlockY, Period,
+                                    Lacunarity, Gain, Octaves);
+            PerlinSampleOctavesCoarseGrid(Noise, Coarse, BlockDim, BlockDim, BlockX, BlockY, Period,
+                                          Lacunarity, Gain, Octaves, Spacing);
+            for (i32 SampleI = 0;
+                 SampleI < BlockDim * BlockDim;
+                 ++SampleI)
+            {
+                f32 Difference = Exact[SampleI] - Coarse[SampleI];
+                Error = Max(Error, (Difference < 0.0f) ? -Difference : Difference);
+            }
+        }
 
-    f32 DotProduct = dX * Gradient.X + dY * Gradient.Y;
-    return DotProduct;
-}
+        if (Error <= MaxError)
+        {
+            Result = Spacing;
+        }
+    }
 
-inline f32
-_PerlinInterpolate(f32 A0, f32 A1, f32 W)
-{
-    f32 Result = (A1 - A0) * (3.0f - W * 2.0f) * W * W * A0;
     return Result;
 }
 
 inline f32
-PerlinSample(perlin_state *PerlinState, f32 X, f32 Y)
+PerlinNormalize(f32 Intensity)
 {
-    u8 SeedLow8 = (u8) PerlinState->Seed;
-
-    i32 X0 = (i32) X;
-    i32 X1 = X0 + 1;
-    i32 Y0 = (i32) Y;
-    i32 Y1 = Y0 + 1;
-
-    f32 N00 = _PerlinGridDotGradient(PerlinState, X0, Y0, X, Y, SeedLow8);
-    f32 N01 = _PerlinGridDotGradient(PerlinState, X0, Y1, X, Y, SeedLow8);
-    f32 N10 = _PerlinGridDotGradient(PerlinState, X1, Y0, X, Y, SeedLow8);
-    f32 N11 = _PerlinGridDotGradient(PerlinState, X1, Y1, X, Y, SeedLow8);
-
-    f32 sX = X - (f32) X0;
-    f32 sY = Y - (f32) Y0;
-
-    f32 InterpolatedX0 = _PerlinInterpolate(N00, N10, sX);
-    f32 InterpolatedX1 = _PerlinInterpolate(N01, N11, sX);
+    if (Intensity > 1.0f)
+    {
+        Intensity = 1.0f;
+    }
+    else if (Intensity < -1.0f)
+    {
+        Intensity = -1.0f;
+    }
 
-    f32 Result = _PerlinInterpolate(InterpolatedX0, InterpolatedX1, sY);
-    return Result;
+    Intensity *= 0.5f;
+    Intensity += 0.5f;
+    
+    return Intensity;
 }
-#endif
 
 #endif
@@ -6,200 +6,11 @@
 #include "savour_platform.h"
 #include "savour.h"
 
-#include <ctime>
 #include <climits>
+#include <cstddef> // offsetof
 
-u32
-AlphaBlendBgFg(vec3 Bg, vec3 Fg, f32 Alpha)
-{
-    u8 R = ((u8) ((Bg.R * 255) * (1 - Alpha)) +
-            (u8) ((Fg.R * 255) * (    Alpha)));
-    u8 G = ((u8) ((Bg.G * 255) * (1 - Alpha)) +
-            (u8) ((Fg.G * 255) * (    Alpha)));
-    u8 B = ((u8) ((Bg.B * 255) * (1 - Alpha)) +
-            (u8) ((Fg.B * 255) * (    Alpha)));
-            
-    u32 Result = ((R    << 24) |
-                  (G    << 16) |
-                  (B    << 8 ) |
-                  (0xFF << 0));
-
-    return Result;
-}
-
-u32
-InterpolatePixel(u32 A, u32 B, f32 Ratio)
-{
-    u32 RMask = 0xFF000000;
-    u32 GMask = 0x00FF0000;
-    u32 BMask = 0x0000FF00;
-    u32 AMask = 0x000000FF;
-
-    u8 aR = (u8) ((A & RMask) >> 24);
-    u8 aG = (u8) ((A & GMask) >> 16);
-    u8 aB = (u8) ((A & BMask) >> 8 );
-    u8 aA = (u8) ((A & AMask) >> 0 );
-
-    u8 bR = (u8) ((B & RMask) >> 24);
-    u8 bG = (u8) ((B & GMask) >> 16);
-    u8 bB = (u8) ((B & BMask) >> 8 );
-    u8 bA = (u8) ((B & AMask) >> 0 );
-
-    u8 cR = (u8) (aR * (1.0f - Ratio)) + (u8) (bR * Ratio);
-    u8 cG = (u8) (aG * (1.0f - Ratio)) + (u8) (bG * Ratio);
-    u8 cB = (u8) (aB * (1.0f - Ratio)) + (u8) (bB * Ratio);
-    u8 cA = (u8) (aA * (1.0f - Ratio)) + (u8) (bA * Ratio);
-
-    u32 Result = ((cR << 24) |
-                  (cG << 16) |
-                  (cB <<  8) |
-                  (cA <<  0));
-
-    return Result;
-}
-
-void
-BlitAlpha(image Source, rect SourceRect, image Dest, rect DestRect, vec3 Bg, vec3 Fg, b32 Bilinear)
-{
-    Assert(SourceRect.X >= 0);
-    Assert(SourceRect.X < Source.Width);
-    Assert(SourceRect.X + SourceRect.Width <= Source.Width);
-    Assert(SourceRect.Y >= 0);
-    Assert(SourceRect.Y < Source.Height);
-    Assert(SourceRect.Y + SourceRect.Height <= Source.Height);
-
-    u32 *SourcePixels = (u32 *) Source.Pixels;
-    u32 *DestPixels = (u32 *) Dest.Pixels;
-
-    i32 DestRectMinX = DestRect.X;
-    if (DestRectMinX > Dest.Width)
-    {
-        return;
-    }
-    else if (DestRectMinX < 0)
-    {
-        DestRectMinX = 0;
-    }
-    i32 DestRectMinY = DestRect.Y;
-    if (DestRectMinY > Dest.Height)
-    {
-        return;
-    }
-    else if (DestRectMinY < 0)
-    {
-        DestRectMinY = 0;
-    }
-
-    i32 DestRectMaxX = DestRect.X + DestRect.Width;
-    if (DestRectMaxX < 0)
-    {
-        return;
-    }
-    else if (DestRectMaxX > Dest.Width)
-    {
-        DestRectMaxX = Dest.Width;
-    }
-    i32 DestRectMaxY = DestRect.Y + DestRect.Height;
-    if (DestRectMaxY < 0)
-    {
-        return;
-    }
-    else if (DestRectMaxY > Dest.Height)
-    {
-        DestRectMaxY = Dest.Height;
-    }
-    
-    for (i32 RowI = DestRectMinY;
-         RowI < DestRectMaxY;
-         ++RowI)
-    {
-        f32 DestRectYRatio = (f32) (RowI - DestRect.Y) / (f32) (DestRect.Height);
-        for (i32 ColumnI = DestRectMinX;
-             ColumnI < DestRectMaxX;
-             ++ColumnI)
-        {
-            u32 *DestPixel = DestPixels + RowI * Dest.Width + ColumnI;
-            
-            f32 DestRectXRatio = (f32) (ColumnI - DestRect.X) / (f32) (DestRect.Width);
-
-            u32 ResultingPixel;
-            
-            u32 SourceX = SourceRect.X + (u32) (DestRectXRatio * SourceRect.Width);
-            u32 SourceY = SourceRect.Y + (u32) (DestRectYRatio * SourceRect.Height);
-            u32 *SourcePixel = SourcePixels + SourceY * Source.Width + SourceX;
-            // printf("D[%u,%u](%0.3f,%0.3f)->S[%u,%u]\n", ColumnI, RowI, DestRectXRatio, DestRectYRatio, SourceX, SourceY);
-            
-            ResultingPixel = *SourcePixel;
-            
-            #if 0
-            if (!Bilinear)
-            {
-                // Nearest neighbor
-                // TODO: Truncate or round?
-                // When I was rounding, everything was shifted half pixel to the left
-                u32 SourceX = SourceRect.X + (u32) (DestRectXRatio * SourceRect.Width);
-                u32 SourceY = SourceRect.Y + (u32) (DestRectYRatio * SourceRect.Height);
-                u32 *SourcePixel = SourcePixels + SourceY * Source.Width + SourceX;
-                // printf("D[%u,%u](%0.3f,%0.3f)->S[%u,%u]\n", ColumnI, RowI, DestRectXRatio, DestRectYRatio, SourceX, SourceY);
-            
-                ResultingPixel = *SourcePixel;
-            }
-            else
-            {
-                // Bilinear interpolation
-                // TODO: Not sure if this even does anything lol. Need to find a way to test this somehow
-                // TODO: We should not sample outside of the source rectangle
-                f32 FloorRectX = FloorF(DestRectXRatio * SourceRect.Width);
-                f32 FloorRectY = FloorF(DestRectYRatio * SourceRect.Height);
-                f32 RatioX = FloorRectX - (f32) ((u32) FloorRectX);
-                f32 RatioY = FloorRectY - (f32) ((u32) FloorRectY);
-            
-                u32 FloorX = SourceRect.X + (u32) FloorRectX;
-                u32 FloorY = SourceRect.Y + (u32) FloorRectY;
-                u32 CeilingX = SourceRect.X + (u32) CeilingF(DestRectXRatio * SourceRect.Width);
-                u32 CeilingY = SourceRect.Y + (u32) CeilingF(DestRectYRatio * SourceRect.Height);
-
-                u32 *Pixel00 = SourcePixels + FloorY * Source.Width + FloorX;
-                u32 *Pixel01 = SourcePixels + FloorY * Source.Width + CeilingX;
-                u32 *Pixel10 = SourcePixels + CeilingY * Source.Width + FloorX;
-                u32 *Pixel11 = SourcePixels + CeilingY * Source.Width + CeilingX;
-
-                ResultingPixel = InterpolatePixel(InterpolatePixel(*Pixel00, *Pixel01, RatioX),
-                                                  InterpolatePixel(*Pixel10, *Pixel11, RatioX),
-                                                  RatioY);
-            }
-            #endif
-            
-            f32 SourceAlpha = (u8) ResultingPixel / 255.0f;
-
-            *DestPixel = AlphaBlendBgFg(Bg, Fg, SourceAlpha);
-        }
-    }
-
-    return;
-}
-
-inline void
-BlitAlphaInvY(image Source, rect SourceRect, image Dest, rect DestRect, vec3 Bg, vec3 Fg, b32 Bilinear)
-{
-    DestRect.Y = -(DestRect.Y - Dest.Height) - DestRect.Height;
-    BlitAlpha(Source, SourceRect, Dest, DestRect, Bg, Fg, Bilinear);
-}
-
-void
-RenderGlyph(font_atlas FontAtlas, u8 Glyph, image ScreenImage, rect DestRect, vec3 ForegroundColor, vec3 BackgroundColor)
-{
-    i32 GlyphX = (i32) Glyph % FontAtlas.AtlasWidth;
-    i32 GlyphY = (i32) Glyph / FontAtlas.AtlasWidth;
-    
-    rect SourceRect = {};
-    SourceRect.X = GlyphX * FontAtlas.GlyphPxWidth;
-    SourceRect.Y = GlyphY * FontAtlas.GlyphPxHeight;
-    SourceRect.Width = FontAtlas.GlyphPxWidth;
-    SourceRect.Height = FontAtlas.GlyphPxHeight;
-    
-    BlitAlphaInvY(FontAtlas.Image, SourceRect, ScreenImage, DestRect, ForegroundColor, BackgroundColor, false);
-}
+#include "savour_render.cpp"
+#include "savour_world.cpp"
 
 u32
 GetMapIndex(vec3i Position, i32 MapWidth)
@@ -286,45 +97,6 @@ GetEntityParentNode(entity_node *MapTable, i32 MapWidth, entity_node *ChildEntit
 }
 #endif
 
-inline i32
-GetChunkFromTile(i32 Tile, i32 ChunkDim)
-{
-    Assert(INT_MIN + ChunkDim <= Tile);
-    
-    if (Tile < 0)
-    {
-        Tile -= ChunkDim - 1;
-    }
-
-    i32 Result = Tile / ChunkDim;
-    return Result;
-}
-
-inline i32
-GetLeftmostTileFromChunk(i32 Chunk, i32 ChunkDim)
-{
-    i32 Tile = Chunk * ChunkDim;
-    return Tile;
-}
-
-inline vec3i
-GetChunkPFromTileP(vec3i TileP, vec3i ChunkDim)
-{
-    vec3i ChunkP = Vec3I(GetChunkFromTile(TileP.X, ChunkDim.X),
-                         GetChunkFromTile(TileP.Y, ChunkDim.Y),
-                         GetChunkFromTile(TileP.Z, ChunkDim.Z));
-    return ChunkP;
-}
-
-inline vec3i
-GetLeftmostTilePFromChunkP(vec3i ChunkP, vec3i ChunkDim)
-{
-    vec3i TileP = Vec3I(GetLeftmostTileFromChunk(ChunkP.X, ChunkDim.X),
-                        GetLeftmostTileFromChunk(ChunkP.Y, ChunkDim.Y),
-                        GetLeftmostTileFromChunk(ChunkP.Z, ChunkDim.Z));
-    return TileP;
-}
-
 inline i32
 GetTileFromPixel(i32 Pixel, i32 TileDim)
 {
@@ -397,175 +169,60 @@ CalculateChunkRectInCameraView(i32 ScreenWidth, i32 ScreenHeight, vec2i TileDim,
     #endif
 }
 
-entity *
-GetFreeEntity(game_state *GameState)
+// NOTE: 0 when the tile's chunk isn't loaded, or is still being generated. Changes go through SetTileInWorld.
+u16 *
+GetTileInWorld(game_state *GameState, vec3i TileP)
 {
-    entity *Result;
-    
-    if (GameState->EntityFreeList)
-    {
-        Result = GameState->EntityFreeList;
-        GameState->EntityFreeList = GameState->EntityFreeList->Next;
-        Result->Next = 0;
-    }
-    else
+    tile_cursor Cursor = MakeTileCursor(&GameState->Chunks, GameState->ChunkDim, TileP);
+    u16 *Result = GetTileAtCursor(&Cursor);
+    return Result;
+}
+
+// NOTE: False when the tile's chunk isn't loaded, or is still being generated
+b32
+SetTileInWorld(game_state *GameState, vec3i TileP, u16 Tile)
+{
+    b32 Result = false;
+
+    tile_cursor Cursor = MakeTileCursor(&GameState->Chunks, GameState->ChunkDim, TileP);
+    u16 *CursorTile = GetTileAtCursor(&Cursor);
+    if (CursorTile)
     {
-        Assert(GameState->NextEmptyEntityIndex < WorldEntityCount);
-        Result = GameState->WorldEntities + GameState->NextEmptyEntityIndex++;
+        *CursorTile = Tile;
+        Cursor.Chunk->IsSaved = false;
+        Result = true;
     }
 
-    Assert(Result);
-
     return Result;
 }
 
-void
-DebugMap(memory_arena *TransientArena, i32 MinX, i32 MinY, i32 MaxX, i32 MaxY,
-         platform_image *Out_ContinentalPerlin, platform_image *Out_TerrainPerlin, platform_image *Out_MapImage)
+// NOTE: Touches every chunk in the rect and queues generation of the missing ones. Returns false when the backlog
+// filled up before every missing chunk was queued, the rest gets queued on a later call.
+b32
+RequestChunksInRect(game_state *GameState, vec3i ChunkMin, vec3i ChunkMax)
 {
-    u32 Width = MaxX - MinX + 1;
-    u32 Height = MaxY - MinY + 1;
-    Out_ContinentalPerlin->Width = Width;
-    Out_ContinentalPerlin->Height = Height;
-    Out_TerrainPerlin->Width = Width;
-    Out_TerrainPerlin->Height = Height;
-    Out_MapImage->Width = Width;
-    Out_MapImage->Height = Height;
-
-    Out_ContinentalPerlin->ImageData = (void *) MemoryArena_PushArray(TransientArena, Width * Height, u32);
-    Out_TerrainPerlin->ImageData = (void *) MemoryArena_PushArray(TransientArena, Width * Height, u32);
-    Out_MapImage->ImageData = (void *) MemoryArena_PushArray(TransientArena, Width * Height, u32);
-
-    u32 *ContinentalP = (u32 *) Out_ContinentalPerlin->ImageData;
-    u32 *TerrainP = (u32 *) Out_TerrainPerlin->ImageData;
-    u32 *MapP = (u32 *) Out_MapImage->ImageData;
-    for (i32 Y = MinY;
-         Y <= MaxY;
-         ++Y)
+    b32 AllRequested = true;
+
+    for (i32 ChunkY = ChunkMin.Y;
+         ChunkY <= ChunkMax.Y;
+         ++ChunkY)
     {
-        for (i32 X = MinX;
-             X <= MaxX;
-             ++X)
+        for (i32 ChunkX = ChunkMin.X;
+             ChunkX <= ChunkMax.X;
+             ++ChunkX)
         {
-            // f32 ContinentalIntensity = PerlinSampleOctaves(X / 256.0f, Y / 256.0f, 1.3f, 0.3f, 4, 100);
-            f32 ContinentalIntensity = PerlinSampleOctaves(X / 256.0f, Y / 256.0f, 2.1f, 0.3f, 4, 100) * 2.0f - 0.3f;
-            ContinentalIntensity = PerlinNormalize(ContinentalIntensity);
-
-            u8 ContinentalByte = (u8) (ContinentalIntensity * 255.0f);
-            *ContinentalP++ = (ContinentalByte << 24 |
-                           ContinentalByte << 16 |
-                           ContinentalByte << 8  |
-                           255);
-
-
-            f32 Intensity = PerlinSampleOctaves(X / 32.0f, Y / 32.0f, 1.8f, 0.5f, 6, 101);
-            Intensity = PerlinNormalize(Intensity);
-
-            u8 TerrainByte = (u8) (Intensity * 255.0f);
-            *TerrainP++ = (TerrainByte << 24 |
-                           TerrainByte << 16 |
-                           TerrainByte << 8  |
-                           255);
-
-            if (ContinentalIntensity < 0.5f || Intensity <= 0.4f)
-            {
-                // NOTE: Water
-                *MapP = 0x0000FFFF;
-            }
-            else if (Intensity >= 0.6f)
-            {
-                // NOTE: Mountain
-                *MapP = 0xAAAAAAFF;
-            }
-            else
-            {
-                // NOTE: Grass
-                *MapP = 0x00FF00FF;
-            }
-
-            if (X == 0 && Y == 0)
+            vec3i RequestedP = Vec3I(ChunkX, ChunkY, ChunkMin.Z);
+            if (!UseChunk(&GameState->Chunks, RequestedP))
             {
-                *MapP = 0x000000FF;
+                if (!AllRequested || !RequestChunk(&GameState->ChunkGeneration, RequestedP))
+                {
+                    AllRequested = false;
+                }
             }
-
-            *MapP++;
         }
     }
-}
 
-void
-GenerateChunkTerrain(vec3i ChunkP, game_state *GameState, memory_arena *WorldArena)
-{
-    local_persist i32 CurrentIndex = 0;
-    printf("Gen ch#%d - P(%d,%d,%d)... ", CurrentIndex++, ChunkP.X, ChunkP.Y, ChunkP.Z);
-    
-    chunk *Chunk = MemoryArena_PushStruct(WorldArena, chunk);
-    Chunk->P = ChunkP;
-    Chunk->Next = GameState->Chunks;
-    GameState->Chunks = Chunk;
-    
-    for (i32 I = 0;
-         I < ChunkEntityCount;
-         ++I)
-    {
-        entity *TopEntity = GetFreeEntity(GameState);
-
-        i32 X = I % GameState->ChunkDim.X;
-        i32 Y = I / GameState->ChunkDim.Y;
-        i32 Z = ChunkP.Z;
-        
-        vec3i Position = GetLeftmostTilePFromChunkP(ChunkP, GameState->ChunkDim) + Vec3I(X, Y, Z);
-
-        f32 ContinentalIntensity = PerlinSampleOctaves(Position.X / 256.0f, Position.Y / 256.0f, 1.3f, 0.3f, 4, 100);
-        ContinentalIntensity = PerlinNormalize(ContinentalIntensity);
-
-        f32 Intensity = PerlinSampleOctaves(Position.X / 32.0f, Position.Y / 32.0f, 1.8f, 0.5f, 6, 101);
-        Intensity = PerlinNormalize(Intensity);
-
-        // NOTE: Grass
-        TopEntity->Glyph = (((rand() % 2) ==  0) ? 176 : 177);
-        TopEntity->ForegroundColor = Vec3(0.4f, 0.7f, 0.4f);
-        TopEntity->BackgroundColor = Vec3(0.3f, 0.6f, 0.4f);
-        TopEntity->P = Position;
-        TopEntity->IsBlocking = false;
-        TopEntity->IsOpaque = false;
-
-        if (ContinentalIntensity < 0.5f || Intensity <= 0.4f)
-        {
-            // NOTE: Water
-            entity *OldTop = TopEntity;
-            TopEntity = GetFreeEntity(GameState);
-            TopEntity->Next = OldTop;
-            
-            TopEntity->Glyph = (((rand() % 2) ==  0) ? 247 : 126);
-            TopEntity->ForegroundColor = Vec3(0.3f, 0.3f, 0.8f);
-            TopEntity->BackgroundColor = Vec3(0.2f, 0.2f, 0.6f);
-            TopEntity->P = Position;
-            TopEntity->IsBlocking = false;
-            TopEntity->IsOpaque = false;
-        }
-        else if (Intensity >= 0.6f)
-        {
-            // NOTE: Mountain
-            entity *OldTop = TopEntity;
-            TopEntity = GetFreeEntity(GameState);
-            TopEntity->Next = OldTop;
-            
-            TopEntity->Glyph = (((rand() % 2) == 0) ? '#' : '%');
-            TopEntity->ForegroundColor = Vec3(0.42f);
-            TopEntity->BackgroundColor = Vec3(0.4f);
-            TopEntity->P = Position;
-            TopEntity->IsBlocking = true;
-            TopEntity->IsOpaque = true;
-        }
-        else
-        {
-            // NOTE: Grass is always there
-        }
-
-        Chunk->Entities[I] = TopEntity;
-    }
-    printf("Done. E:%d. WA:%zuKB/%zuKB \n", GameState->NextEmptyEntityIndex, WorldArena->Used / 1024, WorldArena->Size / 1024);
+    return AllRequested;
 }
 
 void
@@ -575,28 +232,14 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
 
     if (!GameMemory->IsInitialized)
     {
-        printf("Need %zu MB for entities.\n", (WorldEntityCount * sizeof(entity) / 1024) / 1024);
-        
         // NOTE: Initialize memory arenas
         u8 *RootArenaBase = (u8 *) GameMemory->Storage + sizeof(game_state);
         size_t RootArenaSize = GameMemory->StorageSize - sizeof(game_state);
         GameState->RootArena = MemoryArena(RootArenaBase, RootArenaSize);
 
         GameState->TransientArena = MemoryArenaNested(&GameState->RootArena, Megabytes(64));
-        GameState->WorldArena = MemoryArenaNested(&GameState->RootArena, Megabytes(4));
-
-        // Generate and save map preview
-        platform_image ContinentalPerlin;
-        platform_image TerrainPerlin;
-        platform_image MapImage;
-        DebugMap(&GameState->TransientArena, -512, -512, 512, 512,
-                         &ContinentalPerlin, &TerrainPerlin, &MapImage);
-        Platform_SaveRGBA_BMP(&ContinentalPerlin, "continental", true);
-        Platform_SaveRGBA_BMP(&TerrainPerlin, "terrain", true);
-        Platform_SaveRGBA_BMP(&MapImage, "map", true);
-        
-        // TODO: Temporary
-        srand((u32)time(NULL));
+        GameState->WorldArena = MemoryArenaNested(&GameState->RootArena, Megabytes(8));
+        GameState->FrameArena = MemoryArenaNested(&GameState->RootArena, Megabytes(4));
 
         // NOTE: Initialize font atas;
         GameState->FontAtlas.Image = GetImageFromPlatformImage(Platform_LoadBMP("resources/font.bmp"));
@@ -604,6 +247,33 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
         GameState->FontAtlas.AtlasHeight = 16;
         GameState->FontAtlas.GlyphPxWidth = 48;
         GameState->FontAtlas.GlyphPxHeight = 72;
+        BuildFontAtlasMips(&GameState->FontAtlas, &GameState->RootArena);
+
+        // NOTE: Pick the fastest blit path the CPU supports
+        #if SAVOUR_INTERNAL
+        DEBUG_ValidateBlitPaths(GameState->FontAtlas, &GameState->TransientArena);
+        DEBUG_ValidateGlyphCache(GameState->FontAtlas, &GameState->TransientArena);
+        #endif
+        GlobalBlitPath = ChooseBlitPath();
+        printf("Blit path: %s\n", GetBlitPathName(GlobalBlitPath));
+
+        // NOTE: Initialize palette
+        InitPalette(&GameState->Palette, &GameState->RootArena);
+
+        // NOTE: Initialize tile types
+        u16 GrassColorPair = AddColorPair(&GameState->Palette, Vec3(0.3f, 0.6f, 0.4f), Vec3(0.4f, 0.7f, 0.4f));
+        u16 WaterColorPair = AddColorPair(&GameState->Palette, Vec3(0.2f, 0.2f, 0.6f), Vec3(0.3f, 0.3f, 0.8f));
+        u16 MountainColorPair = AddColorPair(&GameState->Palette, Vec3(0.4f), Vec3(0.42f));
+        u16 PlaceholderColorPair = AddColorPair(&GameState->Palette, Vec3(0.1f), Vec3(0.25f));
+        world_generator *Generator = &GameState->WorldGenerator;
+        Generator->GrassTileType = AddTileType(&GameState->TileTypes, 176, 177, GrassColorPair, false, false);
+        Generator->WaterTileType = AddTileType(&GameState->TileTypes, 247, 126, WaterColorPair, false, false);
+        Generator->MountainTileType = AddTileType(&GameState->TileTypes, '#', '%', MountainColorPair, true, true);
+        GameState->PlaceholderTile = MakeTileId(AddTileType(&GameState->TileTypes, 250, 250, PlaceholderColorPair,
+                                                            true, true), 0);
+
+        // NOTE: Workers plus this thread
+        GameState->RenderThreadCount = GameMemory->WorkerThreadCount + 1;
 
         // NOTE: Initialize camera
         GameState->CameraZoomMin = 0.2f;
@@ -618,8 +288,26 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
         GameState->TileDim = Vec2I(GameState->FontAtlas.GlyphPxWidth, GameState->FontAtlas.GlyphPxHeight) * CameraZoomCurrent;
         GameState->TileDimForTest = Vec2I(GameState->FontAtlas.GlyphPxWidth, GameState->FontAtlas.GlyphPxHeight) * ExponentialInterpolation(GameState->CameraZoomMin, GameState->CameraZoomMax, 0.0f);
 
+        // NOTE: Sized for the smallest tiles, i.e. the most cells we can ever have on screen
+        InitSoftwareRenderer(&GameState->Renderer, &GameState->RootArena,
+                             Vec2I(OffscreenBuffer->Width, OffscreenBuffer->Height), GameState->TileDimForTest);
+
         // NOTE: Initialize first chunks
         GameState->ChunkDim = Vec3I(16,16,1);
+        Generator->Seed = WorldSeed;
+        Generator->ChunkDim = GameState->ChunkDim;
+        Generator->Continental = NoiseLayer(256.0f, 1.3f, 0.3f, 4, 100);
+        SetNoiseLayerMaxError(&Generator->Continental, ContinentalNoiseMaxError);
+        Generator->Terrain = NoiseLayer(32.0f, 1.8f, 0.5f, 6, 101);
+        InitChunkStore(&GameState->Chunks, &GameState->WorldArena, ChunkMaxResidentCount, ChunkKeepRadius);
+        // NOTE: Only what the player changed is kept, everything else is generated again
+        InitRegionStore(&GameState->Regions, "world", RegionStorage_Edits, Generator, GameMemory->LowPriorityQueue);
+        GameState->Chunks.Regions = &GameState->Regions;
+        InitColdChunkStore(&GameState->ColdChunks, &GameState->WorldArena, (u32) ColdChunkBudgetBytes);
+        GameState->Chunks.Cold = &GameState->ColdChunks;
+        InitChunkGenerationQueue(&GameState->ChunkGeneration, Generator, &GameState->Chunks,
+                                 GameMemory->LowPriorityQueue);
+        GameState->ChunkGenerationBudgetMicroseconds = ChunkGenerationDefaultBudgetMicroseconds;
 
         vec3i ChunkMin, ChunkMax;
         CalculateChunkRectInCameraView(OffscreenBuffer->Width, OffscreenBuffer->Height,
@@ -627,24 +315,45 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
                                        &ChunkMin, &ChunkMax);
         printf("ChunkMin(%d, %d); ChunkMax(%d, %d)\n", ChunkMin.X, ChunkMin.Y, ChunkMax.X, ChunkMax.Y);
 
-        for (i32 ChunkY = ChunkMin.Y;
-             ChunkY <= ChunkMax.Y;
-             ++ChunkY)
+        // NOTE: The first screen full is waited on, so the game doesn't start on placeholders
+        chunk_generation_queue *ChunkGeneration = &GameState->ChunkGeneration;
+        vec3i CameraChunkP = GetChunkPFromTileP(GameState->CameraCenterTile, GameState->ChunkDim);
+        b32 AllRequested = false;
+        while (!AllRequested || GetChunkGenerationPendingCount(ChunkGeneration))
         {
-            for (i32 ChunkX = ChunkMin.X;
-                 ChunkX <= ChunkMax.X;
-                 ++ChunkX)
+            AllRequested = RequestChunksInRect(GameState, ChunkMin, ChunkMax);
+            UpdateChunkGeneration(ChunkGeneration, CameraChunkP, 1.0);
+            if (ChunkGeneration->WorkQueue)
             {
-                GenerateChunkTerrain(Vec3I(ChunkX, ChunkY, GameState->CameraCenterTile.Z), GameState, &GameState->WorldArena);
+                Platform_CompleteAllWork(ChunkGeneration->WorkQueue);
             }
+            PublishGeneratedChunks(ChunkGeneration);
+        }
+
+        // NOTE: After the first chunks, so they never wait for it
+        InitWorldPreview(&GameState->WorldPreview, Generator, GameMemory->LowPriorityQueue);
+        // NOTE: Opening creates the file when it isn't there, empty, which reads as on
+        GameState->IsWorldPreviewOnStartup = true;
+        if (Platform_CreateDirectory("temp"))
+        {
+            platform_file File = Platform_OpenFile(WorldPreviewOnStartupPath);
+            u32 IsOn;
+            if (File.IsOpen && Platform_ReadFile(&File, 0, &IsOn, sizeof(IsOn)))
+            {
+                GameState->IsWorldPreviewOnStartup = (IsOn != 0);
+            }
+            Platform_CloseFile(&File);
+        }
+        if (GameState->IsWorldPreviewOnStartup)
+        {
+            StartWorldPreview(&GameState->WorldPreview, &GameState->RootArena);
         }
 
         // NOTE: Create player entity
         {
             GameState->Player.P = GameState->CameraCenterTile;
             GameState->Player.Glyph = '@';
-            GameState->Player.ForegroundColor = Vec3(0);
-            GameState->Player.BackgroundColor = Vec3(0,0,1);
+            GameState->Player.ColorPair = AddColorPair(&GameState->Palette, Vec3(0,0,1), Vec3(0));
             GameState->Player.IsBlocking = true;
             GameState->Player.IsOpaque = false;
         }
@@ -652,8 +361,7 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
         {
             GameState->OtherEntity.P = GameState->CameraCenterTile + Vec3I(3, 3, 0);
             GameState->OtherEntity.Glyph = 'A';
-            GameState->OtherEntity.ForegroundColor = Vec3(0);
-            GameState->OtherEntity.BackgroundColor = Vec3(0,1,0);
+            GameState->OtherEntity.ColorPair = AddColorPair(&GameState->Palette, Vec3(0,1,0), Vec3(0));
             GameState->OtherEntity.IsBlocking = true;
             GameState->OtherEntity.IsOpaque = false;
         }
@@ -661,10 +369,67 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
         GameMemory->IsInitialized = true;
     } // NOTE: DONE INIT
 
-    if (Platform_KeyIsDown(GameInput, SDL_SCANCODE_ESCAPE))
+    if (Platform_KeyIsDown(GameInput, SDL_SCANCODE_ESCAPE) || GameInput->QuitRequested)
     {
+        SaveAllChunks(&GameState->Chunks);
         *GameShouldQuit = true;
     }
+
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F1))
+    {
+        GameState->RedrawAllCells = !GameState->RedrawAllCells;
+    }
+
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F4))
+    {
+        GameState->IsBilinear = !GameState->IsBilinear;
+        GameState->Renderer.CellGrid.RedrawAll = true;
+    }
+
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F2))
+    {
+        GameState->RenderThreadCount = GameState->RenderThreadCount % (GameMemory->WorkerThreadCount + 1) + 1;
+    }
+
+    // NOTE: Chunk generation on the workers or on the main thread, and the main thread's budget, to tune it for
+    // machines without cores to spare
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F7) && GameMemory->LowPriorityQueue)
+    {
+        chunk_generation_queue *ChunkGeneration = &GameState->ChunkGeneration;
+        ChunkGeneration->WorkQueue = ChunkGeneration->WorkQueue ? 0 : GameMemory->LowPriorityQueue;
+    }
+
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F8))
+    {
+        u32 Budget = GameState->ChunkGenerationBudgetMicroseconds * 2;
+        GameState->ChunkGenerationBudgetMicroseconds = (Budget > 8000) ? 250 : Budget;
+    }
+
+    // NOTE: Draws the world preview, unless it's on disk already
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_M))
+    {
+        world_preview *WorldPreview = &GameState->WorldPreview;
+        if (!StartWorldPreview(WorldPreview, &GameState->RootArena) && !WorldPreview->IsRunning)
+        {
+            printf("World preview: already saved as temp/%s.bmp\n", GetWorldPreviewName(WorldPreview, "map").D);
+        }
+    }
+
+    // NOTE: Takes effect the next time the game starts, a preview that's being drawn carries on
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_P))
+    {
+        GameState->IsWorldPreviewOnStartup = !GameState->IsWorldPreviewOnStartup;
+        u32 IsOn = GameState->IsWorldPreviewOnStartup ? 1 : 0;
+        b32 IsSaved = false;
+        if (Platform_CreateDirectory("temp"))
+        {
+            platform_file File = Platform_OpenFile(WorldPreviewOnStartupPath);
+            IsSaved = (File.IsOpen && Platform_WriteFile(&File, 0, &IsOn, sizeof(IsOn)) &&
+                       Platform_SetFileSize(&File, sizeof(IsOn)));
+            Platform_CloseFile(&File);
+        }
+        printf("World preview on startup: %s%s\n", IsOn ? "on" : "off", IsSaved ? "" : ", couldn't save it");
+    }
     
     b32 PlayerMoved = false;
     vec3i NewPlayerPosition = GameState->Player.P;
@@ -713,8 +478,28 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
         PlayerMoved = true;
     }
 
+    vec3i PlayerStep = NewPlayerPosition - GameState->Player.P;
+    UpdatePrefetchVelocity(&GameState->Prefetcher, Vec2((f32) PlayerStep.X, (f32) PlayerStep.Y), GameInput->DeltaTime);
+
     GameState->Player.P = NewPlayerPosition;
     GameState->CameraCenterTile = GameState->Player.P;
+
+    #if SAVOUR_INTERNAL
+    // NOTE: Changes the terrain under the player, so there's something for the region files to keep
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_B))
+    {
+        u16 *Tile = GetTileInWorld(GameState, GameState->Player.P);
+        if (Tile)
+        {
+            world_generator *Generator = &GameState->WorldGenerator;
+            u16 Type = GetTileTypeIndex(*Tile);
+            u16 NextType = (Type == Generator->GrassTileType) ? Generator->WaterTileType :
+                           (Type == Generator->WaterTileType) ? Generator->MountainTileType :
+                           Generator->GrassTileType;
+            SetTileInWorld(GameState, GameState->Player.P, MakeTileId(NextType, *Tile & 1));
+        }
+    }
+    #endif
     if (PlayerMoved)
     {
         // printf("%d,%d,%d\n", GameState->Player.P.X, GameState->Player.P.Y, GameState->Player.P.Z);
@@ -724,24 +509,8 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
     #if 0
     if (PlayerMoved)
     {
-        entity_node *TestEntityNode = GameState->MapTable + GetMapIndex(NewPlayerPosition, GameState->MapWidth);
-
-        if (TestEntityNode->IsPopulated)
-        {
-            b32 FoundBlocking = false;
-            entity_node *CurrentEntityNode = TestEntityNode;
-            while(CurrentEntityNode)
-            {
-                if (CurrentEntityNode->E.IsBlocking)
-                {
-                    PlayerMoved = false;
-                    break;
-                }
-
-                CurrentEntityNode = CurrentEntityNode->Next;
-            }
-        }
-        else
+        u16 *Tile = GetTileInWorld(GameState, NewPlayerPosition);
+        if (!Tile || GetTileType(&GameState->TileTypes, *Tile)->IsBlocking)
         {
             PlayerMoved = false;
         }
@@ -824,31 +593,27 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
                                    &ChunkMin, &ChunkMax);
     // printf("ChunkMin(%d, %d); ChunkMax(%d, %d)\n", ChunkMin.X, ChunkMin.Y, ChunkMax.X, ChunkMax.Y);
 
-    // NOTE: Initialize chunks that haven't been yet
-    for (i32 ChunkY = ChunkMin.Y;
-         ChunkY <= ChunkMax.Y;
-         ++ChunkY)
+    // NOTE: Pick up what the workers finished since last frame, then queue what's still missing
+    vec3i CameraChunkP = GetChunkPFromTileP(GameState->CameraCenterTile, GameState->ChunkDim);
+    PublishGeneratedChunks(&GameState->ChunkGeneration);
+    CountNewlyVisibleChunks(&GameState->Prefetcher, &GameState->Chunks.Table, ChunkMin, ChunkMax);
+    RequestChunksInRect(GameState, ChunkMin, ChunkMax);
+
+    // NOTE: Chunks ahead of the player only get what the view leaves over, so they wait until everything in view
+    // is on its way
+    if (!GameState->ChunkGeneration.BacklogCount)
     {
-        for (i32 ChunkX = ChunkMin.X;
-             ChunkX <= ChunkMax.X;
-             ++ChunkX)
-        {
-            vec3i RequestedP = Vec3I(ChunkX, ChunkY, GameState->CameraCenterTile.Z);
-            chunk *SearchChunk = GameState->Chunks;
-            while (SearchChunk)
-            {
-                if (Vec3IAreEqual(SearchChunk->P, RequestedP))
-                {
-                    break;
-                }
-                SearchChunk = SearchChunk->Next;
-            }
-            if (!SearchChunk)
-            {
-                GenerateChunkTerrain(Vec3I(ChunkX, ChunkY, 0), GameState, &GameState->WorldArena);
-            }
-        }
+        vec3i PrefetchMin, PrefetchMax;
+        GetPrefetchRect(&GameState->Prefetcher, GameState->ChunkGeneration.SecondsPerChunk, GameState->ChunkDim,
+                        ChunkMin, ChunkMax, &PrefetchMin, &PrefetchMax);
+        RequestChunksInRect(GameState, PrefetchMin, PrefetchMax);
     }
+    UpdateChunkGeneration(&GameState->ChunkGeneration, CameraChunkP,
+                          GameState->ChunkGenerationBudgetMicroseconds / 1000000.0);
+
+    EvictChunks(&GameState->Chunks, CameraChunkP);
+    UpdateRegionWrites(&GameState->Regions);
+    UpdateWorldPreview(&GameState->WorldPreview);
     
     // printf("TileDim(%d,%d); CameraTileOffset(%0.5f,%0.5f)\n", GameState->TileDim.X, GameState->TileDim.Y, GameState->CameraTileOffset.X, GameState->CameraTileOffset.Y);
 
@@ -856,19 +621,20 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
     // NOTE: RENDER
     //
     
-    image ScreenImage = {};
-    ScreenImage.Pixels = OffscreenBuffer->ImageData;
-    ScreenImage.Width = OffscreenBuffer->Width;
-    ScreenImage.Height = OffscreenBuffer->Height;
+    image ScreenImage = GetImageFromPlatformImage(*OffscreenBuffer);
     
     vec2i TileHalfDim = GameState->TileDim * 0.5f;
     vec2i ScreenHalfDim = Vec2I(ScreenImage.Width, ScreenImage.Height) * 0.5f;
     vec2i CameraPxOffset = Vec2I(GameState->CameraTileOffset * Vec2(GameState->TileDim));
     vec2i AllCameraOffsets = ScreenHalfDim - TileHalfDim + CameraPxOffset;
 
-    rect DestRect = {};
-    DestRect.Width = GameState->TileDim.X;
-    DestRect.Height = GameState->TileDim.Y;
+    // NOTE: Tiles are pushed relative to the camera tile, the renderer takes it from there
+    MemoryArena_Reset(&GameState->FrameArena);
+    render_commands Commands = BeginRenderCommands(&GameState->FrameArena,
+                                                   RenderLayer_Count * GameState->Renderer.CellGrid.CellCapacity,
+                                                   Vec2I(ScreenImage.Width, ScreenImage.Height), GameState->TileDim,
+                                                   AllCameraOffsets, GameState->IsBilinear);
+    vec2i CameraTileP = Vec2I(GameState->CameraCenterTile);
 
     for (i32 ChunkY = ChunkMin.Y;
          ChunkY <= ChunkMax.Y;
@@ -886,34 +652,43 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
     //          ChunkX <= 100;
     //          ++ChunkX)
     //     {
-            vec3i RequestedP = Vec3I(ChunkX, ChunkY, GameState->CameraCenterTile.Z);
-            chunk *Chunk = GameState->Chunks;
-            while (Chunk)
+            vec3i ChunkP = Vec3I(ChunkX, ChunkY, GameState->CameraCenterTile.Z);
+            chunk *Chunk = GetChunk(&GameState->Chunks.Table, ChunkP);
+            vec2i ChunkTileP = Vec2I(GetLeftmostTilePFromChunkP(ChunkP, GameState->ChunkDim)) - CameraTileP;
+            if (Chunk && Chunk->State == ChunkState_Ready)
             {
-                if (Vec3IAreEqual(Chunk->P, RequestedP))
+                u16 *Tile = Chunk->Tiles;
+                for (i32 Y = 0;
+                     Y < GameState->ChunkDim.Y;
+                     ++Y)
                 {
-                    break;
+                    for (i32 X = 0;
+                         X < GameState->ChunkDim.X;
+                         ++X)
+                    {
+                        PushTile(&Commands, ChunkTileP + Vec2I(X, Y), GetTileGlyph(&GameState->TileTypes, *Tile),
+                                 GetTileType(&GameState->TileTypes, *Tile)->ColorPair, RenderLayer_Terrain);
+                        ++Tile;
+                    }
                 }
-                Chunk = Chunk->Next;
             }
-            if (Chunk)
+            else
             {
-                for (u32 ChunkEntityI = 0;
-                     ChunkEntityI < ChunkEntityCount;
-                     ++ChunkEntityI)
+                // NOTE: Still on a worker, or not even queued yet because every job was taken
+                u8 Glyph = GetTileGlyph(&GameState->TileTypes, GameState->PlaceholderTile);
+                u16 ColorPair = GetTileType(&GameState->TileTypes, GameState->PlaceholderTile)->ColorPair;
+                for (i32 Y = 0;
+                     Y < GameState->ChunkDim.Y;
+                     ++Y)
                 {
-                    entity *TopEntity = Chunk->Entities[ChunkEntityI];
-
-                    vec2i EntityRelPxP = (Vec2I(TopEntity->P) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-                    DestRect.X = EntityRelPxP.X;
-                    DestRect.Y = EntityRelPxP.Y;
-                    RenderGlyph(GameState->FontAtlas, TopEntity->Glyph, ScreenImage, DestRect, TopEntity->BackgroundColor, TopEntity->ForegroundColor);
+                    for (i32 X = 0;
+                         X < GameState->ChunkDim.X;
+                         ++X)
+                    {
+                        PushTile(&Commands, ChunkTileP + Vec2I(X, Y), Glyph, ColorPair, RenderLayer_Terrain);
+                    }
                 }
             }
-            else
-            {
-                Noop;
-            }
         }
     }
     
@@ -923,14 +698,12 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
          ++I)
     {
         entity *Entity = AdditionalEntities[I];
-
-        vec2i EntityRelPxP = (Vec2I(Entity->P) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-        DestRect.X = EntityRelPxP.X;
-        DestRect.Y = EntityRelPxP.Y;
-        RenderGlyph(GameState->FontAtlas, Entity->Glyph, ScreenImage, DestRect, Entity->BackgroundColor, Entity->ForegroundColor);
+        PushTile(&Commands, Vec2I(Entity->P) - CameraTileP, Entity->Glyph, Entity->ColorPair, RenderLayer_Entities);
     }
 
     #if 0
+    u16 ChunkColorPair = AddColorPair(&GameState->Palette, Vec3(0,0,1), Vec3(0,1,0));
+    u16 BorderColorPair = AddColorPair(&GameState->Palette, Vec3(1), Vec3(0));
     vec3i *Chunks[] = { &ChunkMin, &ChunkMax };
 
     for (u32 I = 0;
@@ -948,10 +721,7 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
                  X < Max.X;
                  ++X)
             {
-                vec2i EntityRelPxP = (Vec2I(X, Y) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-                DestRect.X = EntityRelPxP.X;
-                DestRect.Y = EntityRelPxP.Y;
-                RenderGlyph(GameState->FontAtlas, '+', ScreenImage, DestRect, Vec3(0,0,1), Vec3(0,1,0));
+                PushTile(&Commands, Vec2I(X, Y) - CameraTileP, '+', ChunkColorPair, RenderLayer_Debug);
             }
         }
     }
@@ -960,32 +730,100 @@ GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_ima
          X <= TileMaxX;
          ++X)
     {
-        vec2i EntityRelPxP = (Vec2I(X, TileMinY) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-        DestRect.X = EntityRelPxP.X;
-        DestRect.Y = EntityRelPxP.Y;
-        RenderGlyph(GameState->FontAtlas, '#', ScreenImage, DestRect, Vec3(1), Vec3(0));
-
-        EntityRelPxP = (Vec2I(X, TileMaxY) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-        DestRect.X = EntityRelPxP.X;
-        DestRect.Y = EntityRelPxP.Y;
-        RenderGlyph(GameState->FontAtlas, '#', ScreenImage, DestRect, Vec3(1), Vec3(0));
-
+        PushTile(&Commands, Vec2I(X, TileMinY) - CameraTileP, '#', BorderColorPair, RenderLayer_Debug);
+        PushTile(&Commands, Vec2I(X, TileMaxY) - CameraTileP, '#', BorderColorPair, RenderLayer_Debug);
     }
 
     for (i32 Y = TileMinY;
          Y <= TileMaxY;
          ++Y)
     {
-        vec2i EntityRelPxP = (Vec2I(TileMinX, Y) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-        DestRect.X = EntityRelPxP.X;
-        DestRect.Y = EntityRelPxP.Y;
-        RenderGlyph(GameState->FontAtlas, '#', ScreenImage, DestRect, Vec3(1), Vec3(0));
+        PushTile(&Commands, Vec2I(TileMinX, Y) - CameraTileP, '#', BorderColorPair, RenderLayer_Debug);
+        PushTile(&Commands, Vec2I(TileMaxX, Y) - CameraTileP, '#', BorderColorPair, RenderLayer_Debug);
+    }
+    #endif
 
-        EntityRelPxP = (Vec2I(TileMaxX, Y) - Vec2I(GameState->CameraCenterTile)) * GameState->TileDim + AllCameraOffsets;
-        DestRect.X = EntityRelPxP.X;
-        DestRect.Y = EntityRelPxP.Y;
-        RenderGlyph(GameState->FontAtlas, '#', ScreenImage, DestRect, Vec3(1), Vec3(0));
+    software_renderer *Renderer = &GameState->Renderer;
+    if (GameState->RedrawAllCells || OffscreenBuffer->ContentsLost)
+    {
+        Renderer->CellGrid.RedrawAll = true;
+    }
+    SoftwareRenderCommands(Renderer, &Commands, &GameState->FontAtlas, &GameState->Palette, ScreenImage,
+                           GameMemory->HighPriorityQueue, GameState->RenderThreadCount);
 
+    #if SAVOUR_INTERNAL
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F3))
+    {
+        DEBUG_BenchmarkRenderCommands(Renderer, &Commands, &GameState->FontAtlas, &GameState->Palette, ScreenImage,
+                                      GameMemory->HighPriorityQueue, GameMemory->WorkerThreadCount + 1,
+                                      &GameState->TransientArena);
+    }
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F5))
+    {
+        // NOTE: Most zoomed out, from the full size atlas and from the mip the game uses, then the current zoom
+        font_atlas MinZoomFontAtlas = GetFontAtlasMip(&GameState->FontAtlas,
+                                                      ChooseFontAtlasMip(&GameState->FontAtlas, GameState->TileDimForTest));
+        font_atlas FontAtlas = GetFontAtlasMip(&GameState->FontAtlas,
+                                               ChooseFontAtlasMip(&GameState->FontAtlas, GameState->TileDim));
+        DEBUG_BenchmarkGlyphFilters(GameState->FontAtlas, GameState->TileDimForTest,
+                                    Vec2I(ScreenImage.Width, ScreenImage.Height), &GameState->TransientArena);
+        DEBUG_BenchmarkGlyphFilters(MinZoomFontAtlas, GameState->TileDimForTest,
+                                    Vec2I(ScreenImage.Width, ScreenImage.Height), &GameState->TransientArena);
+        DEBUG_BenchmarkGlyphFilters(FontAtlas, GameState->TileDim,
+                                    Vec2I(ScreenImage.Width, ScreenImage.Height), &GameState->TransientArena);
+    }
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F6))
+    {
+        DEBUG_BenchmarkChunkTable(&GameState->TransientArena);
+    }
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F9))
+    {
+        DEBUG_BenchmarkRegionFiles(&GameState->WorldGenerator, &GameState->TransientArena);
+    }
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F10))
+    {
+        DEBUG_BenchmarkColdChunks(&GameState->WorldGenerator, &GameState->TransientArena);
+    }
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F11))
+    {
+        DEBUG_BenchmarkTileCursor(&GameState->TransientArena);
+    }
+    if (Platform_KeyJustPressed(GameInput, SDL_SCANCODE_F12))
+    {
+        DEBUG_BenchmarkChunkNoise(&GameState->WorldGenerator, &GameState->TransientArena);
     }
     #endif
+
+    // NOTE: Taken after the benchmarks, which redraw the whole grid
+    cell_grid *CellGrid = &Renderer->CellGrid;
+    OffscreenBuffer->DirtyRects = CellGrid->DirtyRects;
+    OffscreenBuffer->DirtyRectCount = CellGrid->DirtyRectCount;
+
+    chunk_store *ChunkStore = &GameState->Chunks;
+    chunk_generation_queue *ChunkGeneration = &GameState->ChunkGeneration;
+    simple_string GenerationMode = ChunkGeneration->WorkQueue
+        ? SimpleString("workers")
+        : SimpleStringF("%uus/frame", GameState->ChunkGenerationBudgetMicroseconds);
+    chunk_prefetcher *Prefetcher = &GameState->Prefetcher;
+    u32 PrefetchHitPercent = Prefetcher->NewlyVisibleCount
+        ? (u32) (100 * (u64) Prefetcher->HitCount / Prefetcher->NewlyVisibleCount)
+        : 100;
+    cold_chunk_store *ColdChunks = &GameState->ColdChunks;
+    u32 ColdLookupCount = ColdChunks->HitCount + ColdChunks->MissCount;
+    u32 ColdHitPercent = ColdLookupCount ? (u32) (100 * (u64) ColdChunks->HitCount / ColdLookupCount) : 0;
+    f32 ColdRatio = ColdChunks->LiveBytes
+        ? (f32) (ColdChunks->Count * ChunkTileCount * sizeof(u16)) / (f32) ColdChunks->LiveBytes
+        : 0.0f;
+    GameMemory->PerfStatus = SimpleStringF("Cells redrawn: %u/%d, threads: %u, %s, chunks: %u resident, %u free, "
+                                           "%u evicted, generation: %u backlog, %u in progress, %s, "
+                                           "prefetch: %u%% hit, regions: %u loaded, %u saved, "
+                                           "cold: %u (%uKB, %.1fx), %u%% hit",
+                                           CellGrid->CellsRedrawn, CellGrid->Width * CellGrid->Height,
+                                           GameState->RenderThreadCount, GameState->IsBilinear ? "bilinear" : "nearest",
+                                           ChunkStore->ResidentCount, ChunkStore->FreeCount, ChunkStore->EvictedCount,
+                                           ChunkGeneration->BacklogCount,
+                                           GetChunkGenerationPendingCount(ChunkGeneration) - ChunkGeneration->BacklogCount,
+                                           GenerationMode.D, PrefetchHitPercent, GameState->Regions.LoadedCount,
+                                           GameState->Regions.SavedCount, ColdChunks->Count,
+                                           ColdChunks->UsedBytes / 1024, ColdRatio, ColdHitPercent);
 }
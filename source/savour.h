@@ -4,49 +4,14 @@
 #include "and_common.h"
 
 #include "savour_platform.h"
-
-struct image
-{
-    i32 Width;
-    i32 Height;
-    void *Pixels;
-};
-
-struct rect
-{
-    i32 X;
-    i32 Y;
-    i32 Width;
-    i32 Height;
-};
-
-inline image GetImageFromPlatformImage(platform_image PlatformImage)
-{
-    image Result = {};
-    
-    Result.Width = PlatformImage.Width;
-    Result.Height = PlatformImage.Height;
-    Result.Pixels = PlatformImage.ImageData;
-
-    return Result;
-}
-
-struct font_atlas
-{
-    image Image;
-    i32 AtlasWidth;
-    i32 AtlasHeight;
-    i32 GlyphPxWidth;
-    i32 GlyphPxHeight;
-};
+#include "savour_render.h"
+#include "savour_world.h"
 
 struct entity
 {
-    // TODO: Maybe the visual of an entity should "palletized"
     u8 Glyph;
-    // TODO: Store the 2 colors as 2 u32s
-    vec3 ForegroundColor;
-    vec3 BackgroundColor;
+    // NOTE: Index into the palette
+    u16 ColorPair;
     
     vec3i P;
     
@@ -57,35 +22,52 @@ struct entity
     entity *Next;
 };
 
-// NOTE: Chunk 16x16x1
-#define ChunkEntityCount 256
-struct chunk
-{
-    vec3i P;
-    
-    entity *Entities[ChunkEntityCount];
-
-    chunk *Next;
-};
-
-#define WorldEntityCount 1000000 //16384
+#define WorldSeed 0x5A70112ull
+
+// NOTE: About 1.2MB of chunks, more than a screen full at the lowest zoom several times over
+#define ChunkMaxResidentCount 2048
+#define ChunkKeepRadius 8
+// NOTE: Dropped chunks compressed in memory, around a hundred bytes each, so about five times as many again
+#define ColdChunkBudgetBytes Megabytes(1)
+// NOTE: How far continents may be from sampling every tile, in noise units. They change slowly enough that sampling
+// every 16 tiles stays within this, see DEBUG_BenchmarkChunkNoise.
+#define ContinentalNoiseMaxError 0.001f
+// NOTE: Main thread time per frame for chunk generation, when there are no workers to do it
+#define ChunkGenerationDefaultBudgetMicroseconds 2000
+// NOTE: Whether the world preview is drawn at startup when it isn't on disk yet, P flips it. The file is a single u32,
+// non-zero for on, and it's on when the file is missing or shorter than that. M draws the preview any time.
+#define WorldPreviewOnStartupPath "temp/world_preview_on_startup"
 
 struct game_state
 {
     memory_arena RootArena;
     memory_arena WorldArena;
     memory_arena TransientArena;
+    // NOTE: Reset at the start of every frame
+    memory_arena FrameArena;
     
     font_atlas FontAtlas;
+    palette Palette;
     b32 IsBilinear;
 
-    // TODO: Need a hash table
-    chunk *Chunks;
-    vec3i ChunkDim;
+    software_renderer Renderer;
+    b32 RedrawAllCells;
+    u32 RenderThreadCount;
 
-    entity WorldEntities[WorldEntityCount];
-    u32 NextEmptyEntityIndex;
-    entity *EntityFreeList;
+    chunk_store Chunks;
+    region_store Regions;
+    cold_chunk_store ColdChunks;
+    vec3i ChunkDim;
+    world_generator WorldGenerator;
+    chunk_generation_queue ChunkGeneration;
+    u32 ChunkGenerationBudgetMicroseconds;
+    chunk_prefetcher Prefetcher;
+    world_preview WorldPreview;
+    b32 IsWorldPreviewOnStartup;
+
+    tile_type_table TileTypes;
+    // NOTE: Drawn in place of chunks that aren't generated yet
+    u16 PlaceholderTile;
 
     entity Player;
     entity OtherEntity;
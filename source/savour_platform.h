@@ -33,22 +33,55 @@ struct game_input
     f32 MouseLogicalDeltaY;
 
     f32 DeltaTime;
+
+    // NOTE: Set by the platform when the window is closed, the game saves what it has to and quits as for Escape
+    b32 QuitRequested;
 };
 
+struct platform_work_queue;
+typedef void platform_work_queue_callback(platform_work_queue *Queue, void *Data);
+
 struct game_memory
 {
     b32 IsInitialized;
 
     size_t StorageSize;
     void *Storage;
+
+    // NOTE: Work queue serviced by WorkerThreadCount threads, plus the main thread while it waits in
+    // Platform_CompleteAllWork
+    platform_work_queue *HighPriorityQueue;
+    u32 WorkerThreadCount;
+    // NOTE: Background work that may take several frames, on threads of its own. Nothing waits on it.
+    platform_work_queue *LowPriorityQueue;
+
+    // NOTE: Set by the game every frame, shown next to the frame time
+    simple_string PerfStatus;
+};
+
+// NOTE: In pixels, top row first
+struct platform_rect
+{
+    i32 X;
+    i32 Y;
+    i32 Width;
+    i32 Height;
 };
 
 struct platform_image
 {
     i32 Width;
     i32 Height;
+    // NOTE: Bytes from one row to the next, at least Width * 4
+    i32 Pitch;
     void *ImageData;
     void *PointerToFree_;
+    // NOTE: Set when ImageData doesn't hold the previous frame, so everything has to be drawn again
+    b32 ContentsLost;
+    // NOTE: Set by the game every frame, the parts of ImageData it drew into, so only those have to be shown again.
+    // The rects point into game memory and are good until the next frame.
+    platform_rect *DirtyRects;
+    u32 DirtyRectCount;
 };
 
 void GameUpdateAndRender(game_input *GameInput, game_memory *GameMemory, platform_image *OffscreenBuffer, b32 *GameShouldQuit);
@@ -57,6 +90,67 @@ platform_image Platform_LoadBMP(const char *Path);
 platform_image Platform_LoadImage(const char *Path);
 void Platform_FreeImage(platform_image *PlatformImage);
 void Platform_SaveRGBA_BMP(platform_image *PlatformImage, const char *Name, b32 Timestamp = true);
+b32 Platform_HasSSE2();
+b32 Platform_HasAVX2();
+f64 Platform_GetSeconds();
+
+// NOTE: A whole file mapped read only, Data is 0 when it doesn't exist or couldn't be mapped. Writes to the file from
+// anywhere show up in the mapping, as long as they don't go past Size.
+struct platform_mapped_file
+{
+    void *Data;
+    u64 Size;
+};
+
+platform_mapped_file Platform_MapFile(const char *Path);
+void Platform_UnmapFile(platform_mapped_file *MappedFile);
+
+// NOTE: Opened for reading and writing at any offset, and created when it doesn't exist. Any thread can use these,
+// one file at a time.
+struct platform_file
+{
+    b32 IsOpen;
+    u64 Size;
+    void *Handle_;
+};
+
+platform_file Platform_OpenFile(const char *Path);
+b32 Platform_ReadFile(platform_file *File, u64 Offset, void *Data, u32 Size);
+b32 Platform_WriteFile(platform_file *File, u64 Offset, void *Data, u32 Size);
+// NOTE: Cuts the file short, or grows it with zeros. Fails on Windows while the file is mapped anywhere.
+b32 Platform_SetFileSize(platform_file *File, u64 Size);
+void Platform_CloseFile(platform_file *File);
+// NOTE: True when the directory is there afterwards, whether or not it was just created
+b32 Platform_CreateDirectory(const char *Path);
+
+// NOTE: Atomics for the game side of the work queues. AtomicAddU32 returns the value from before the add.
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+#define CompletePreviousWritesBeforeFutureWrites _WriteBarrier(); _mm_sfence()
+#define CompletePreviousReadsBeforeFutureReads _ReadBarrier()
+
+inline u32
+AtomicAddU32(u32 volatile *Value, u32 Addend)
+{
+    u32 Result = (u32) _InterlockedExchangeAdd((long volatile *) Value, (long) Addend);
+    return Result;
+}
+#else
+#define CompletePreviousWritesBeforeFutureWrites __atomic_thread_fence(__ATOMIC_RELEASE)
+#define CompletePreviousReadsBeforeFutureReads __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+inline u32
+AtomicAddU32(u32 volatile *Value, u32 Addend)
+{
+    u32 Result = __atomic_fetch_add(Value, Addend, __ATOMIC_SEQ_CST);
+    return Result;
+}
+#endif
+
+// NOTE: Entries can only be added from the main thread
+void Platform_AddWorkEntry(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data);
+void Platform_CompleteAllWork(platform_work_queue *Queue);
 
 inline b32
 Platform_KeyIsDown(game_input *GameInput, u32 KeyScancode)
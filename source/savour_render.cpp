@@ -0,0 +1,2164 @@
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// NOTE: MSVC lets us use AVX2 intrinsics anywhere, gcc/clang need the function tagged
+#if defined(__GNUC__) || defined(__clang__)
+#define SAVOUR_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SAVOUR_TARGET_AVX2
+#endif
+
+global_variable blit_path GlobalBlitPath = BlitPath_Scalar;
+
+u32
+AlphaBlendBgFg(vec3 Bg, vec3 Fg, f32 Alpha)
+{
+    u8 R = ((u8) ((Bg.R * 255) * (1 - Alpha)) +
+            (u8) ((Fg.R * 255) * (    Alpha)));
+    u8 G = ((u8) ((Bg.G * 255) * (1 - Alpha)) +
+            (u8) ((Fg.G * 255) * (    Alpha)));
+    u8 B = ((u8) ((Bg.B * 255) * (1 - Alpha)) +
+            (u8) ((Fg.B * 255) * (    Alpha)));
+
+    u32 Result = ((R    << 24) |
+                  (G    << 16) |
+                  (B    << 8 ) |
+                  (0xFF << 0));
+
+    return Result;
+}
+
+inline u8
+ColorChannelToU8(f32 Channel)
+{
+    u8 Result = (u8) (ClampF(Channel, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return Result;
+}
+
+inline u32
+PackColor(vec3 Color)
+{
+    u32 Result = (((u32) ColorChannelToU8(Color.R) << 24) |
+                  ((u32) ColorChannelToU8(Color.G) << 16) |
+                  ((u32) ColorChannelToU8(Color.B) << 8 ) |
+                  (0xFF << 0));
+    return Result;
+}
+
+inline blit_colors
+GetBlitColors(color_pair *ColorPair)
+{
+    blit_colors Result = {};
+
+    Result.BgR = (u8) (ColorPair->Background >> 24);
+    Result.BgG = (u8) (ColorPair->Background >> 16);
+    Result.BgB = (u8) (ColorPair->Background >> 8);
+    Result.FgR = (u8) (ColorPair->Foreground >> 24);
+    Result.FgG = (u8) (ColorPair->Foreground >> 16);
+    Result.FgB = (u8) (ColorPair->Foreground >> 8);
+    Result.BlendTable = ColorPair->BlendTable;
+
+    return Result;
+}
+
+// NOTE: (Bg * (255 - Alpha) + Fg * Alpha) / 255, rounded. The sum never exceeds 255*255+128, so the SIMD
+// kernels can do exactly the same math in unsigned 16 bit lanes.
+inline u32
+BlendChannel(u32 Bg, u32 Fg, u32 Alpha)
+{
+    u32 X = Bg * (255 - Alpha) + Fg * Alpha + 128;
+    u32 Result = (X + (X >> 8)) >> 8;
+    return Result;
+}
+
+inline u32
+BlendPixel(blit_colors Colors, u32 Alpha)
+{
+    u32 Result = ((BlendChannel(Colors.BgR, Colors.FgR, Alpha) << 24) |
+                  (BlendChannel(Colors.BgG, Colors.FgG, Alpha) << 16) |
+                  (BlendChannel(Colors.BgB, Colors.FgB, Alpha) << 8 ) |
+                  (0xFF << 0));
+    return Result;
+}
+
+void
+InitColorPair(color_pair *ColorPair, u32 Background, u32 Foreground)
+{
+    ColorPair->Background = Background;
+    ColorPair->Foreground = Foreground;
+
+    blit_colors Colors = GetBlitColors(ColorPair);
+    for (u32 Alpha = 0;
+         Alpha < 256;
+         ++Alpha)
+    {
+        ColorPair->BlendTable[Alpha] = BlendPixel(Colors, Alpha);
+    }
+}
+
+// NOTE: Fixed point source step per destination pixel. Source rects are glyphs, so always under 256 px, which
+// leaves 24 bits of fraction. With the step rounded up, U >> BlitFractionBits is then exactly
+// floor(I * SourceDim / DestDim) for any destination size under 4096 px, the same texel the float reference picks.
+#define BlitFractionBits 24
+
+inline u32
+GetBlitStep(i32 SourceDim, i32 DestDim)
+{
+    Assert(SourceDim < 256);
+    u32 Result = (((u32) SourceDim << BlitFractionBits) + (u32) DestDim - 1) / (u32) DestDim;
+    return Result;
+}
+
+b32
+ClipBlitDestRect(image Dest, rect DestRect, blit_clip *Out_Clip)
+{
+    i32 DestRectMinX = DestRect.X;
+    if (DestRectMinX > Dest.Width)
+    {
+        return false;
+    }
+    else if (DestRectMinX < 0)
+    {
+        DestRectMinX = 0;
+    }
+    i32 DestRectMinY = DestRect.Y;
+    if (DestRectMinY > Dest.Height)
+    {
+        return false;
+    }
+    else if (DestRectMinY < 0)
+    {
+        DestRectMinY = 0;
+    }
+
+    i32 DestRectMaxX = DestRect.X + DestRect.Width;
+    if (DestRectMaxX < 0)
+    {
+        return false;
+    }
+    else if (DestRectMaxX > Dest.Width)
+    {
+        DestRectMaxX = Dest.Width;
+    }
+    i32 DestRectMaxY = DestRect.Y + DestRect.Height;
+    if (DestRectMaxY < 0)
+    {
+        return false;
+    }
+    else if (DestRectMaxY > Dest.Height)
+    {
+        DestRectMaxY = Dest.Height;
+    }
+
+    Out_Clip->MinX = DestRectMinX;
+    Out_Clip->MinY = DestRectMinY;
+    Out_Clip->MaxX = DestRectMaxX;
+    Out_Clip->MaxY = DestRectMaxY;
+
+    b32 Result = (DestRectMinX < DestRectMaxX && DestRectMinY < DestRectMaxY);
+    return Result;
+}
+
+void
+BlitAlphaReference(image Source, rect SourceRect, image Dest, rect DestRect, vec3 Bg, vec3 Fg, b32 Bilinear)
+{
+
+    blit_clip Clip;
+    if (!ClipBlitDestRect(Dest, DestRect, &Clip))
+    {
+        return;
+    }
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        f32 DestRectYRatio = (f32) (RowI - DestRect.Y) / (f32) (DestRect.Height);
+        for (i32 ColumnI = Clip.MinX;
+             ColumnI < Clip.MaxX;
+             ++ColumnI)
+        {
+            u32 *DestPixel = GetImageRow(Dest, RowI) + ColumnI;
+
+            f32 DestRectXRatio = (f32) (ColumnI - DestRect.X) / (f32) (DestRect.Width);
+
+            f32 SourceAlpha;
+            if (!Bilinear)
+            {
+                // Nearest neighbor
+                // TODO: Truncate or round?
+                // When I was rounding, everything was shifted half pixel to the left
+                u32 SourceX = SourceRect.X + (u32) (DestRectXRatio * SourceRect.Width);
+                u32 SourceY = SourceRect.Y + (u32) (DestRectYRatio * SourceRect.Height);
+                u32 *SourcePixel = GetImageRow(Source, SourceY) + SourceX;
+
+                SourceAlpha = (u8) *SourcePixel / 255.0f;
+            }
+            else
+            {
+                // NOTE: Bilinear interpolation, with texel centers at +0.5 and the taps clamped to the edge
+                // texels of the source rect
+                f32 SourceU = (((f32) (ColumnI - DestRect.X) + 0.5f) * SourceRect.Width / DestRect.Width) - 0.5f;
+                f32 SourceV = (((f32) (RowI - DestRect.Y) + 0.5f) * SourceRect.Height / DestRect.Height) - 0.5f;
+                SourceU = ClampF(SourceU, 0.0f, (f32) (SourceRect.Width - 1));
+                SourceV = ClampF(SourceV, 0.0f, (f32) (SourceRect.Height - 1));
+
+                i32 X0 = (i32) SourceU;
+                i32 Y0 = (i32) SourceV;
+                i32 X1 = Min(X0 + 1, SourceRect.Width - 1);
+                i32 Y1 = Min(Y0 + 1, SourceRect.Height - 1);
+                f32 RatioX = SourceU - (f32) X0;
+                f32 RatioY = SourceV - (f32) Y0;
+
+                u32 *Row0 = GetImageRow(Source, SourceRect.Y + Y0) + SourceRect.X;
+                u32 *Row1 = GetImageRow(Source, SourceRect.Y + Y1) + SourceRect.X;
+                f32 Alpha0 = (u8) Row0[X0] + RatioX * ((f32) (u8) Row0[X1] - (f32) (u8) Row0[X0]);
+                f32 Alpha1 = (u8) Row1[X0] + RatioX * ((f32) (u8) Row1[X1] - (f32) (u8) Row1[X0]);
+
+                SourceAlpha = (Alpha0 + RatioY * (Alpha1 - Alpha0)) / 255.0f;
+            }
+
+            *DestPixel = AlphaBlendBgFg(Bg, Fg, SourceAlpha);
+        }
+    }
+
+    return;
+}
+
+//
+// NOTE: Fixed point span kernels. Source coordinates are stepped in 8.24 per destination pixel, only the
+// alpha byte of the source is used and the blend is done in integer math. All of them produce bit-identical
+// output, the scalar one is also used for the row tails of the SIMD ones.
+//
+
+internal inline void
+BlitAlphaSpanScalar(u32 *SourceRow, u32 *DestPixel, u32 U, u32 StepX, i32 Count, blit_colors Colors)
+{
+    for (i32 I = 0;
+         I < Count;
+         ++I)
+    {
+        *DestPixel++ = Colors.BlendTable[(u8) SourceRow[U >> BlitFractionBits]];
+        U += StepX;
+    }
+}
+
+internal void
+BlitAlphaScalar(image Source, rect SourceRect, image Dest, blit_clip Clip, rect DestRect, blit_colors Colors)
+{
+
+    u32 StepX = GetBlitStep(SourceRect.Width, DestRect.Width);
+    u32 StepY = GetBlitStep(SourceRect.Height, DestRect.Height);
+    u32 StartU = (u32) (Clip.MinX - DestRect.X) * StepX;
+    i32 Count = Clip.MaxX - Clip.MinX;
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u32 V = (u32) (RowI - DestRect.Y) * StepY;
+        u32 *SourceRow = GetImageRow(Source, SourceRect.Y + (V >> BlitFractionBits)) + SourceRect.X;
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        BlitAlphaSpanScalar(SourceRow, DestPixel, StartU, StepX, Count, Colors);
+    }
+}
+
+// NOTE: Blend constants, two pixels per register in 16 bit lanes, in memory order (A, B, G, R)
+struct blend_sse2
+{
+    __m128i Bg16;
+    __m128i Fg16;
+    __m128i Max16;
+    __m128i Half16;
+};
+
+internal inline blend_sse2
+BlendSSE2(blit_colors Colors)
+{
+    blend_sse2 Result;
+
+    Result.Bg16 = _mm_setr_epi16(0xFF, Colors.BgB, Colors.BgG, Colors.BgR, 0xFF, Colors.BgB, Colors.BgG, Colors.BgR);
+    Result.Fg16 = _mm_setr_epi16(0xFF, Colors.FgB, Colors.FgG, Colors.FgR, 0xFF, Colors.FgB, Colors.FgG, Colors.FgR);
+    Result.Max16 = _mm_set1_epi16(255);
+    Result.Half16 = _mm_set1_epi16(128);
+
+    return Result;
+}
+
+// NOTE: Alpha holds one alpha per 32 bit lane, in the low byte with the rest zero. Returns the 4 blended pixels.
+internal inline __m128i
+BlendPixels4SSE2(blend_sse2 *Blend, __m128i Alpha)
+{
+    // NOTE: Spread each pixel's alpha over its 4 channel lanes
+    Alpha = _mm_or_si128(Alpha, _mm_slli_epi32(Alpha, 16));
+    __m128i Alpha01 = _mm_unpacklo_epi32(Alpha, Alpha);
+    __m128i Alpha23 = _mm_unpackhi_epi32(Alpha, Alpha);
+
+    __m128i X01 = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(Blend->Bg16, _mm_sub_epi16(Blend->Max16, Alpha01)),
+                                              _mm_mullo_epi16(Blend->Fg16, Alpha01)),
+                                Blend->Half16);
+    __m128i X23 = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(Blend->Bg16, _mm_sub_epi16(Blend->Max16, Alpha23)),
+                                              _mm_mullo_epi16(Blend->Fg16, Alpha23)),
+                                Blend->Half16);
+    X01 = _mm_srli_epi16(_mm_add_epi16(X01, _mm_srli_epi16(X01, 8)), 8);
+    X23 = _mm_srli_epi16(_mm_add_epi16(X23, _mm_srli_epi16(X23, 8)), 8);
+
+    __m128i Result = _mm_packus_epi16(X01, X23);
+    return Result;
+}
+
+struct blend_avx2
+{
+    __m256i Bg16;
+    __m256i Fg16;
+    __m256i Max16;
+    __m256i Half16;
+};
+
+SAVOUR_TARGET_AVX2 internal inline blend_avx2
+BlendAVX2(blit_colors Colors)
+{
+    blend_avx2 Result;
+
+    Result.Bg16 = _mm256_setr_epi16(0xFF, Colors.BgB, Colors.BgG, Colors.BgR, 0xFF, Colors.BgB, Colors.BgG, Colors.BgR,
+                                    0xFF, Colors.BgB, Colors.BgG, Colors.BgR, 0xFF, Colors.BgB, Colors.BgG, Colors.BgR);
+    Result.Fg16 = _mm256_setr_epi16(0xFF, Colors.FgB, Colors.FgG, Colors.FgR, 0xFF, Colors.FgB, Colors.FgG, Colors.FgR,
+                                    0xFF, Colors.FgB, Colors.FgG, Colors.FgR, 0xFF, Colors.FgB, Colors.FgG, Colors.FgR);
+    Result.Max16 = _mm256_set1_epi16(255);
+    Result.Half16 = _mm256_set1_epi16(128);
+
+    return Result;
+}
+
+SAVOUR_TARGET_AVX2 internal inline __m256i
+BlendPixels8AVX2(blend_avx2 *Blend, __m256i Alpha)
+{
+    Alpha = _mm256_or_si256(Alpha, _mm256_slli_epi32(Alpha, 16));
+    // NOTE: Unpacks and packs work per 128 bit lane, so pixel order survives the round trip
+    __m256i AlphaLo = _mm256_unpacklo_epi32(Alpha, Alpha);
+    __m256i AlphaHi = _mm256_unpackhi_epi32(Alpha, Alpha);
+
+    __m256i XLo = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(Blend->Bg16, _mm256_sub_epi16(Blend->Max16, AlphaLo)),
+                                                    _mm256_mullo_epi16(Blend->Fg16, AlphaLo)),
+                                   Blend->Half16);
+    __m256i XHi = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(Blend->Bg16, _mm256_sub_epi16(Blend->Max16, AlphaHi)),
+                                                    _mm256_mullo_epi16(Blend->Fg16, AlphaHi)),
+                                   Blend->Half16);
+    XLo = _mm256_srli_epi16(_mm256_add_epi16(XLo, _mm256_srli_epi16(XLo, 8)), 8);
+    XHi = _mm256_srli_epi16(_mm256_add_epi16(XHi, _mm256_srli_epi16(XHi, 8)), 8);
+
+    __m256i Result = _mm256_packus_epi16(XLo, XHi);
+    return Result;
+}
+
+internal void
+BlitAlphaSSE2(image Source, rect SourceRect, image Dest, blit_clip Clip, rect DestRect, blit_colors Colors)
+{
+
+    u32 StepX = GetBlitStep(SourceRect.Width, DestRect.Width);
+    u32 StepY = GetBlitStep(SourceRect.Height, DestRect.Height);
+    u32 StartU = (u32) (Clip.MinX - DestRect.X) * StepX;
+    i32 Count = Clip.MaxX - Clip.MinX;
+
+    blend_sse2 Blend = BlendSSE2(Colors);
+    __m128i AlphaMask = _mm_set1_epi32(0xFF);
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u32 V = (u32) (RowI - DestRect.Y) * StepY;
+        u32 *SourceRow = GetImageRow(Source, SourceRect.Y + (V >> BlitFractionBits)) + SourceRect.X;
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        u32 U = StartU;
+        i32 I = 0;
+        for (;
+             I + 4 <= Count;
+             I += 4)
+        {
+            __m128i Texels = _mm_setr_epi32((i32) SourceRow[(U            ) >> BlitFractionBits],
+                                            (i32) SourceRow[(U + StepX    ) >> BlitFractionBits],
+                                            (i32) SourceRow[(U + StepX * 2) >> BlitFractionBits],
+                                            (i32) SourceRow[(U + StepX * 3) >> BlitFractionBits]);
+            U += StepX * 4;
+
+            _mm_storeu_si128((__m128i *) DestPixel, BlendPixels4SSE2(&Blend, _mm_and_si128(Texels, AlphaMask)));
+            DestPixel += 4;
+        }
+
+        BlitAlphaSpanScalar(SourceRow, DestPixel, U, StepX, Count - I, Colors);
+    }
+}
+
+SAVOUR_TARGET_AVX2 internal void
+BlitAlphaAVX2(image Source, rect SourceRect, image Dest, blit_clip Clip, rect DestRect, blit_colors Colors)
+{
+
+    u32 StepX = GetBlitStep(SourceRect.Width, DestRect.Width);
+    u32 StepY = GetBlitStep(SourceRect.Height, DestRect.Height);
+    u32 StartU = (u32) (Clip.MinX - DestRect.X) * StepX;
+    i32 Count = Clip.MaxX - Clip.MinX;
+
+    blend_avx2 Blend = BlendAVX2(Colors);
+    __m256i AlphaMask = _mm256_set1_epi32(0xFF);
+    __m256i StepU8 = _mm256_set1_epi32((i32) (StepX * 8));
+    __m256i LaneU = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((i32) StepX));
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u32 V = (u32) (RowI - DestRect.Y) * StepY;
+        u32 *SourceRow = GetImageRow(Source, SourceRect.Y + (V >> BlitFractionBits)) + SourceRect.X;
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        __m256i U = _mm256_add_epi32(_mm256_set1_epi32((i32) StartU), LaneU);
+        i32 I = 0;
+        for (;
+             I + 8 <= Count;
+             I += 8)
+        {
+            __m256i Texels = _mm256_i32gather_epi32((const int *) SourceRow, _mm256_srli_epi32(U, BlitFractionBits), 4);
+            U = _mm256_add_epi32(U, StepU8);
+
+            _mm256_storeu_si256((__m256i *) DestPixel, BlendPixels8AVX2(&Blend, _mm256_and_si256(Texels, AlphaMask)));
+            DestPixel += 8;
+        }
+
+        BlitAlphaSpanScalar(SourceRow, DestPixel, StartU + (u32) I * StepX, StepX, Count - I, Colors);
+    }
+}
+
+inline rect
+GetGlyphSourceRect(font_atlas FontAtlas, u8 Glyph)
+{
+    i32 GlyphX = (i32) Glyph % FontAtlas.AtlasWidth;
+    i32 GlyphY = (i32) Glyph / FontAtlas.AtlasWidth;
+
+    rect SourceRect = {};
+    SourceRect.X = GlyphX * FontAtlas.GlyphPxWidth;
+    SourceRect.Y = GlyphY * FontAtlas.GlyphPxHeight;
+    SourceRect.Width = FontAtlas.GlyphPxWidth;
+    SourceRect.Height = FontAtlas.GlyphPxHeight;
+
+    return SourceRect;
+}
+
+//
+// NOTE: Coverage kernels, blending pre-scaled glyph masks from the glyph cache. Same blend as the blit kernels,
+// without any coordinate math.
+//
+
+internal void
+BlitCoverageScalar(u8 *Coverage, i32 CoverageWidth, image Dest, blit_clip Clip, rect DestRect, blit_colors Colors)
+{
+    i32 Count = Clip.MaxX - Clip.MinX;
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u8 *CoverageRow = Coverage + (RowI - DestRect.Y) * CoverageWidth + (Clip.MinX - DestRect.X);
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        for (i32 I = 0;
+             I < Count;
+             ++I)
+        {
+            *DestPixel++ = Colors.BlendTable[CoverageRow[I]];
+        }
+    }
+}
+
+internal void
+BlitCoverageSSE2(u8 *Coverage, i32 CoverageWidth, image Dest, blit_clip Clip, rect DestRect, blit_colors Colors)
+{
+    i32 Count = Clip.MaxX - Clip.MinX;
+
+    blend_sse2 Blend = BlendSSE2(Colors);
+    __m128i Zero = _mm_setzero_si128();
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u8 *CoverageRow = Coverage + (RowI - DestRect.Y) * CoverageWidth + (Clip.MinX - DestRect.X);
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        i32 I = 0;
+        for (;
+             I + 4 <= Count;
+             I += 4)
+        {
+            __m128i Alpha = _mm_cvtsi32_si128(*(i32 *) (CoverageRow + I));
+            Alpha = _mm_unpacklo_epi16(_mm_unpacklo_epi8(Alpha, Zero), Zero);
+
+            _mm_storeu_si128((__m128i *) DestPixel, BlendPixels4SSE2(&Blend, Alpha));
+            DestPixel += 4;
+        }
+
+        for (;
+             I < Count;
+             ++I)
+        {
+            *DestPixel++ = Colors.BlendTable[CoverageRow[I]];
+        }
+    }
+}
+
+SAVOUR_TARGET_AVX2 internal void
+BlitCoverageAVX2(u8 *Coverage, i32 CoverageWidth, image Dest, blit_clip Clip, rect DestRect, blit_colors Colors)
+{
+    i32 Count = Clip.MaxX - Clip.MinX;
+
+    blend_avx2 Blend = BlendAVX2(Colors);
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u8 *CoverageRow = Coverage + (RowI - DestRect.Y) * CoverageWidth + (Clip.MinX - DestRect.X);
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        i32 I = 0;
+        for (;
+             I + 8 <= Count;
+             I += 8)
+        {
+            __m256i Alpha = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *) (CoverageRow + I)));
+
+            _mm256_storeu_si256((__m256i *) DestPixel, BlendPixels8AVX2(&Blend, Alpha));
+            DestPixel += 8;
+        }
+
+        for (;
+             I < Count;
+             ++I)
+        {
+            *DestPixel++ = Colors.BlendTable[CoverageRow[I]];
+        }
+    }
+}
+
+void
+BlitCoverage(blit_path BlitPath, u8 *Coverage, image Dest, rect DestRect, blit_colors Colors)
+{
+    blit_clip Clip;
+    if (!ClipBlitDestRect(Dest, DestRect, &Clip))
+    {
+        return;
+    }
+
+    switch (BlitPath)
+    {
+        case BlitPath_Reference:
+        case BlitPath_Scalar:
+        {
+            BlitCoverageScalar(Coverage, DestRect.Width, Dest, Clip, DestRect, Colors);
+        } break;
+        case BlitPath_SSE2:
+        {
+            BlitCoverageSSE2(Coverage, DestRect.Width, Dest, Clip, DestRect, Colors);
+        } break;
+        case BlitPath_AVX2:
+        {
+            BlitCoverageAVX2(Coverage, DestRect.Width, Dest, Clip, DestRect, Colors);
+        } break;
+        default:
+        {
+            InvalidCodePath;
+        } break;
+    }
+}
+
+//
+// NOTE: Bilinear sampling. Texel centers are at +0.5 and taps are clamped to the edge texels of the source rect, so
+// neighbouring glyphs in the atlas never bleed in. Each destination row is resampled into a row of coverage, first
+// vertically into 16 bit (alpha * 256), then horizontally, both with 8 bit weights. The vertical pass runs over
+// contiguous texels, so that's the one done in SIMD, and the coverage is then blended with the coverage kernels.
+//
+
+#define BilinearMaxRowWidth 1024
+#define BilinearCoverageBatchSize (16 * BilinearMaxRowWidth)
+
+struct bilinear_sampler
+{
+    image Source;
+    rect SourceRect;
+    u32 StepY;
+
+    i32 ColumnCount;
+    u32 ColumnIndex[BilinearMaxRowWidth];
+    u32 ColumnNextIndex[BilinearMaxRowWidth];
+    u32 ColumnWeight[BilinearMaxRowWidth];
+};
+
+// NOTE: Position is in 8.24 texels, with the half texel to the texel center already added
+internal inline void
+GetBilinearTap(u32 Position, i32 SourceDim, u32 *Out_Index, u32 *Out_NextIndex, u32 *Out_Weight)
+{
+    u32 Half = 1 << (BlitFractionBits - 1);
+    u32 Index = 0;
+    u32 Weight = 0;
+    if (Position > Half)
+    {
+        Position -= Half;
+        Index = Position >> BlitFractionBits;
+        Weight = (Position >> (BlitFractionBits - 8)) & 0xFF;
+    }
+    if (Index >= (u32) SourceDim - 1)
+    {
+        Index = (u32) SourceDim - 1;
+        Weight = 0;
+    }
+
+    *Out_Index = Index;
+    *Out_NextIndex = Min(Index + 1, (u32) SourceDim - 1);
+    *Out_Weight = Weight;
+}
+
+// NOTE: Sets up sampling of SourceRect stretched to DestDim, for ColumnCount columns starting at FirstColumn of
+// the destination. SourceRect can be changed afterwards for another rect of the same size.
+internal void
+InitBilinearSampler(bilinear_sampler *Sampler, image Source, rect SourceRect, vec2i DestDim,
+                    i32 FirstColumn, i32 ColumnCount)
+{
+    Assert(ColumnCount <= BilinearMaxRowWidth);
+
+    Sampler->Source = Source;
+    Sampler->SourceRect = SourceRect;
+    Sampler->StepY = GetBlitStep(SourceRect.Height, DestDim.Y);
+    Sampler->ColumnCount = ColumnCount;
+
+    u32 StepX = GetBlitStep(SourceRect.Width, DestDim.X);
+    for (i32 ColumnI = 0;
+         ColumnI < ColumnCount;
+         ++ColumnI)
+    {
+        u32 Position = (u32) (FirstColumn + ColumnI) * StepX + StepX / 2;
+        GetBilinearTap(Position, SourceRect.Width, Sampler->ColumnIndex + ColumnI,
+                       Sampler->ColumnNextIndex + ColumnI, Sampler->ColumnWeight + ColumnI);
+    }
+}
+
+internal void
+BilinearVerticalScalar(u32 *Row0, u32 *Row1, u32 Weight, i32 Count, u16 *Out)
+{
+    for (i32 I = 0;
+         I < Count;
+         ++I)
+    {
+        Out[I] = (u16) ((u8) Row0[I] * (256 - Weight) + (u8) Row1[I] * Weight);
+    }
+}
+
+internal void
+BilinearVerticalSSE2(u32 *Row0, u32 *Row1, u32 Weight, i32 Count, u16 *Out)
+{
+    __m128i AlphaMask = _mm_set1_epi32(0xFF);
+    __m128i Weight0 = _mm_set1_epi16((i16) (256 - Weight));
+    __m128i Weight1 = _mm_set1_epi16((i16) Weight);
+
+    i32 I = 0;
+    for (;
+         I + 8 <= Count;
+         I += 8)
+    {
+        __m128i A = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128((__m128i *) (Row0 + I)), AlphaMask),
+                                    _mm_and_si128(_mm_loadu_si128((__m128i *) (Row0 + I + 4)), AlphaMask));
+        __m128i B = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128((__m128i *) (Row1 + I)), AlphaMask),
+                                    _mm_and_si128(_mm_loadu_si128((__m128i *) (Row1 + I + 4)), AlphaMask));
+
+        // NOTE: At most 255 * 256, so the low 16 bits of the products are the whole thing
+        __m128i Result = _mm_add_epi16(_mm_mullo_epi16(A, Weight0), _mm_mullo_epi16(B, Weight1));
+        _mm_storeu_si128((__m128i *) (Out + I), Result);
+    }
+
+    BilinearVerticalScalar(Row0 + I, Row1 + I, Weight, Count - I, Out + I);
+}
+
+// NOTE: Row is relative to the top of the destination rect
+internal void
+SampleBilinearRow(blit_path BlitPath, bilinear_sampler *Sampler, i32 Row, u8 *Out)
+{
+    rect SourceRect = Sampler->SourceRect;
+
+    u32 RowIndex;
+    u32 NextRowIndex;
+    u32 RowWeight;
+    GetBilinearTap((u32) Row * Sampler->StepY + Sampler->StepY / 2, SourceRect.Height,
+                   &RowIndex, &NextRowIndex, &RowWeight);
+
+    u32 *Row0 = GetImageRow(Sampler->Source, SourceRect.Y + (i32) RowIndex) + SourceRect.X;
+    u32 *Row1 = GetImageRow(Sampler->Source, SourceRect.Y + (i32) NextRowIndex) + SourceRect.X;
+
+    // NOTE: Only the source columns the taps actually touch
+    u32 FirstIndex = Sampler->ColumnIndex[0];
+    i32 IndexCount = (i32) (Sampler->ColumnNextIndex[Sampler->ColumnCount - 1] - FirstIndex) + 1;
+
+    u16 Vertical[256];
+    if (BlitPath == BlitPath_SSE2 || BlitPath == BlitPath_AVX2)
+    {
+        BilinearVerticalSSE2(Row0 + FirstIndex, Row1 + FirstIndex, RowWeight, IndexCount, Vertical);
+    }
+    else
+    {
+        BilinearVerticalScalar(Row0 + FirstIndex, Row1 + FirstIndex, RowWeight, IndexCount, Vertical);
+    }
+
+    u16 *VerticalBase = Vertical - FirstIndex;
+    for (i32 I = 0;
+         I < Sampler->ColumnCount;
+         ++I)
+    {
+        u32 Top = VerticalBase[Sampler->ColumnIndex[I]];
+        u32 Bottom = VerticalBase[Sampler->ColumnNextIndex[I]];
+        u32 Weight = Sampler->ColumnWeight[I];
+        Out[I] = (u8) ((Top * (256 - Weight) + Bottom * Weight + (1 << 15)) >> 16);
+    }
+}
+
+internal void
+BlitAlphaBilinear(blit_path BlitPath, image Source, rect SourceRect, image Dest, blit_clip Clip, rect DestRect,
+                  blit_colors Colors)
+{
+    bilinear_sampler Sampler;
+    i32 Count = Clip.MaxX - Clip.MinX;
+    InitBilinearSampler(&Sampler, Source, SourceRect, Vec2I(DestRect.Width, DestRect.Height),
+                        Clip.MinX - DestRect.X, Count);
+
+    // NOTE: Resampled a batch of rows at a time, so the blend setup is paid once per batch instead of once per row
+    u8 Coverage[BilinearCoverageBatchSize];
+    i32 BatchRowCount = BilinearCoverageBatchSize / Count;
+    for (i32 BatchMinY = Clip.MinY;
+         BatchMinY < Clip.MaxY;
+         BatchMinY += BatchRowCount)
+    {
+        i32 BatchMaxY = Min(BatchMinY + BatchRowCount, Clip.MaxY);
+        for (i32 RowI = BatchMinY;
+             RowI < BatchMaxY;
+             ++RowI)
+        {
+            SampleBilinearRow(BlitPath, &Sampler, RowI - DestRect.Y, Coverage + (RowI - BatchMinY) * Count);
+        }
+
+        blit_clip BatchClip = { Clip.MinX, BatchMinY, Clip.MaxX, BatchMaxY };
+        rect BatchRect = { Clip.MinX, BatchMinY, Count, BatchMaxY - BatchMinY };
+        switch (BlitPath)
+        {
+            case BlitPath_SSE2:
+            {
+                BlitCoverageSSE2(Coverage, Count, Dest, BatchClip, BatchRect, Colors);
+            } break;
+            case BlitPath_AVX2:
+            {
+                BlitCoverageAVX2(Coverage, Count, Dest, BatchClip, BatchRect, Colors);
+            } break;
+            default:
+            {
+                BlitCoverageScalar(Coverage, Count, Dest, BatchClip, BatchRect, Colors);
+            } break;
+        }
+    }
+}
+
+//
+// NOTE: Font atlas mips
+//
+
+// NOTE: Each texel is the rounded average of the 2x2 texels above it, per channel
+internal void
+HalveImage(image Source, image Dest)
+{
+    Assert(Dest.Width * 2 == Source.Width && Dest.Height * 2 == Source.Height);
+
+    for (i32 Y = 0;
+         Y < Dest.Height;
+         ++Y)
+    {
+        u32 *Row0 = GetImageRow(Source, 2 * Y);
+        u32 *Row1 = GetImageRow(Source, 2 * Y + 1);
+        u32 *DestPixel = GetImageRow(Dest, Y);
+        for (i32 X = 0;
+             X < Dest.Width;
+             ++X)
+        {
+            u32 A = Row0[2 * X];
+            u32 B = Row0[2 * X + 1];
+            u32 C = Row1[2 * X];
+            u32 D = Row1[2 * X + 1];
+
+            u32 Result = 0;
+            for (u32 Shift = 0;
+                 Shift < 32;
+                 Shift += 8)
+            {
+                u32 Sum = (((A >> Shift) & 0xFF) + ((B >> Shift) & 0xFF) +
+                           ((C >> Shift) & 0xFF) + ((D >> Shift) & 0xFF) + 2);
+                Result |= (Sum >> 2) << Shift;
+            }
+            *DestPixel++ = Result;
+        }
+    }
+}
+
+void
+BuildFontAtlasMips(font_atlas *FontAtlas, memory_arena *Arena)
+{
+    FontAtlas->MipImages[0] = FontAtlas->Image;
+    FontAtlas->MipCount = 1;
+
+    i32 GlyphWidth = FontAtlas->GlyphPxWidth;
+    i32 GlyphHeight = FontAtlas->GlyphPxHeight;
+    while (FontAtlas->MipCount < FontAtlasMaxMipCount &&
+           GlyphWidth % 2 == 0 && GlyphHeight % 2 == 0)
+    {
+        image Source = FontAtlas->MipImages[FontAtlas->MipCount - 1];
+        image *Dest = FontAtlas->MipImages + FontAtlas->MipCount;
+        Dest->Width = Source.Width / 2;
+        Dest->Height = Source.Height / 2;
+        Dest->Pitch = Dest->Width * 4;
+        Dest->Pixels = MemoryArena_PushArray(Arena, Dest->Width * Dest->Height, u32);
+        HalveImage(Source, *Dest);
+
+        GlyphWidth /= 2;
+        GlyphHeight /= 2;
+        FontAtlas->MipCount++;
+    }
+}
+
+// NOTE: The smallest mip whose glyphs are still at least TileDim, so glyphs are never magnified from a mip and at most
+// halved from one. Sampling then only touches about as many texels as it writes.
+u32
+ChooseFontAtlasMip(font_atlas *FontAtlas, vec2i TileDim)
+{
+    u32 Result = 0;
+    while (Result + 1 < FontAtlas->MipCount &&
+           (FontAtlas->GlyphPxWidth >> (Result + 1)) >= TileDim.X &&
+           (FontAtlas->GlyphPxHeight >> (Result + 1)) >= TileDim.Y)
+    {
+        Result++;
+    }
+    return Result;
+}
+
+// NOTE: The atlas as seen from one mip, everything that takes a font_atlas can draw from it as is
+font_atlas
+GetFontAtlasMip(font_atlas *FontAtlas, u32 Mip)
+{
+    Assert(Mip < FontAtlas->MipCount);
+
+    font_atlas Result = *FontAtlas;
+    Result.Image = FontAtlas->MipImages[Mip];
+    Result.GlyphPxWidth = FontAtlas->GlyphPxWidth >> Mip;
+    Result.GlyphPxHeight = FontAtlas->GlyphPxHeight >> Mip;
+
+    return Result;
+}
+
+//
+// NOTE: Glyph cache
+//
+
+void
+InitGlyphCache(glyph_cache *GlyphCache, memory_arena *Arena)
+{
+    *GlyphCache = {};
+
+    for (u32 SlotI = 0;
+         SlotI < GlyphCacheSlotCount;
+         ++SlotI)
+    {
+        GlyphCache->Slots[SlotI].Coverage = MemoryArena_PushArray(Arena, 256 * GlyphCacheMaxTilePx, u8);
+    }
+}
+
+inline u8 *
+GetGlyphCoverage(glyph_cache_slot *Slot, u8 Glyph)
+{
+    u8 *Result = Slot->Coverage + (size_t) Glyph * Slot->TileDim.X * Slot->TileDim.Y;
+    return Result;
+}
+
+internal void
+BuildGlyphCacheSlot(glyph_cache_slot *Slot, font_atlas *FontAtlas, vec2i TileDim, b32 Bilinear)
+{
+    Slot->TileDim = TileDim;
+    Slot->Bilinear = Bilinear;
+
+    if (Bilinear)
+    {
+        bilinear_sampler Sampler;
+        InitBilinearSampler(&Sampler, FontAtlas->Image, GetGlyphSourceRect(*FontAtlas, 0), TileDim, 0, TileDim.X);
+
+        for (u32 Glyph = 0;
+             Glyph < 256;
+             ++Glyph)
+        {
+            Sampler.SourceRect = GetGlyphSourceRect(*FontAtlas, (u8) Glyph);
+            u8 *Coverage = GetGlyphCoverage(Slot, (u8) Glyph);
+
+            for (i32 Y = 0;
+                 Y < TileDim.Y;
+                 ++Y)
+            {
+                SampleBilinearRow(GlobalBlitPath, &Sampler, Y, Coverage);
+                Coverage += TileDim.X;
+            }
+        }
+
+        return;
+    }
+
+    u32 StepX = GetBlitStep(FontAtlas->GlyphPxWidth, TileDim.X);
+    u32 StepY = GetBlitStep(FontAtlas->GlyphPxHeight, TileDim.Y);
+
+    for (u32 Glyph = 0;
+         Glyph < 256;
+         ++Glyph)
+    {
+        rect SourceRect = GetGlyphSourceRect(*FontAtlas, (u8) Glyph);
+        u8 *Coverage = GetGlyphCoverage(Slot, (u8) Glyph);
+
+        for (i32 Y = 0;
+             Y < TileDim.Y;
+             ++Y)
+        {
+            u32 V = (u32) Y * StepY;
+            u32 *SourceRow = GetImageRow(FontAtlas->Image, SourceRect.Y + (V >> BlitFractionBits)) + SourceRect.X;
+
+            u32 U = 0;
+            for (i32 X = 0;
+                 X < TileDim.X;
+                 ++X)
+            {
+                *Coverage++ = (u8) SourceRow[U >> BlitFractionBits];
+                U += StepX;
+            }
+        }
+    }
+}
+
+// NOTE: Returns the slot with all glyphs at TileDim, rebuilding the least recently used one on a miss. Returns 0 if
+// the tile is too big to be cached.
+glyph_cache_slot *
+GetGlyphCacheSlot(glyph_cache *GlyphCache, font_atlas *FontAtlas, vec2i TileDim, b32 Bilinear)
+{
+    if (TileDim.X <= 0 || TileDim.Y <= 0 || TileDim.X * TileDim.Y > GlyphCacheMaxTilePx)
+    {
+        return 0;
+    }
+
+    GlyphCache->UseCounter++;
+
+    glyph_cache_slot *Result = 0;
+    glyph_cache_slot *LeastRecentlyUsed = GlyphCache->Slots;
+    for (u32 SlotI = 0;
+         SlotI < GlyphCacheSlotCount;
+         ++SlotI)
+    {
+        glyph_cache_slot *Slot = GlyphCache->Slots + SlotI;
+        if (Slot->TileDim.X == TileDim.X && Slot->TileDim.Y == TileDim.Y && Slot->Bilinear == Bilinear)
+        {
+            Result = Slot;
+            break;
+        }
+        if (Slot->LastUsed < LeastRecentlyUsed->LastUsed)
+        {
+            LeastRecentlyUsed = Slot;
+        }
+    }
+
+    if (!Result)
+    {
+        Result = LeastRecentlyUsed;
+        BuildGlyphCacheSlot(Result, FontAtlas, TileDim, Bilinear);
+        GlyphCache->RebuildCount++;
+    }
+
+    Result->LastUsed = GlyphCache->UseCounter;
+
+    return Result;
+}
+
+blit_path
+ChooseBlitPath()
+{
+    blit_path Result = BlitPath_Scalar;
+
+    if (Platform_HasAVX2())
+    {
+        Result = BlitPath_AVX2;
+    }
+    else if (Platform_HasSSE2())
+    {
+        Result = BlitPath_SSE2;
+    }
+
+    return Result;
+}
+
+inline const char *
+GetBlitPathName(blit_path BlitPath)
+{
+    switch (BlitPath)
+    {
+        case BlitPath_Reference: return "Reference";
+        case BlitPath_Scalar: return "Scalar";
+        case BlitPath_SSE2: return "SSE2";
+        case BlitPath_AVX2: return "AVX2";
+        default: InvalidCodePath; return "";
+    }
+}
+
+// NOTE: Integer paths only, Reference falls back to Scalar like it does for the coverage blits
+void
+BlitAlphaColorPair(blit_path BlitPath, image Source, rect SourceRect, image Dest, rect DestRect, color_pair *ColorPair,
+                   b32 Bilinear)
+{
+    blit_clip Clip;
+    if (!ClipBlitDestRect(Dest, DestRect, &Clip))
+    {
+        return;
+    }
+
+    blit_colors Colors = GetBlitColors(ColorPair);
+
+    if (Bilinear)
+    {
+        BlitAlphaBilinear(BlitPath, Source, SourceRect, Dest, Clip, DestRect, Colors);
+        return;
+    }
+
+    switch (BlitPath)
+    {
+        case BlitPath_Reference:
+        case BlitPath_Scalar:
+        {
+            BlitAlphaScalar(Source, SourceRect, Dest, Clip, DestRect, Colors);
+        } break;
+        case BlitPath_SSE2:
+        {
+            BlitAlphaSSE2(Source, SourceRect, Dest, Clip, DestRect, Colors);
+        } break;
+        case BlitPath_AVX2:
+        {
+            BlitAlphaAVX2(Source, SourceRect, Dest, Clip, DestRect, Colors);
+        } break;
+        default:
+        {
+            InvalidCodePath;
+        } break;
+    }
+}
+
+void
+BlitAlpha(blit_path BlitPath, image Source, rect SourceRect, image Dest, rect DestRect, vec3 Bg, vec3 Fg, b32 Bilinear)
+{
+    Assert(SourceRect.X >= 0);
+    Assert(SourceRect.X < Source.Width);
+    Assert(SourceRect.X + SourceRect.Width <= Source.Width);
+    Assert(SourceRect.Y >= 0);
+    Assert(SourceRect.Y < Source.Height);
+    Assert(SourceRect.Y + SourceRect.Height <= Source.Height);
+
+    if (BlitPath == BlitPath_Reference)
+    {
+        BlitAlphaReference(Source, SourceRect, Dest, DestRect, Bg, Fg, Bilinear);
+    }
+    else
+    {
+        color_pair ColorPair;
+        InitColorPair(&ColorPair, PackColor(Bg), PackColor(Fg));
+        BlitAlphaColorPair(BlitPath, Source, SourceRect, Dest, DestRect, &ColorPair, Bilinear);
+    }
+}
+
+inline void
+BlitAlpha(image Source, rect SourceRect, image Dest, rect DestRect, vec3 Bg, vec3 Fg, b32 Bilinear)
+{
+    BlitAlpha(GlobalBlitPath, Source, SourceRect, Dest, DestRect, Bg, Fg, Bilinear);
+}
+
+// NOTE: GlyphCacheSlot is optional, it has to match the DestRect dimensions if given. DestRect is in image space,
+// top-down.
+void
+DrawGlyph(font_atlas FontAtlas, glyph_cache_slot *GlyphCacheSlot, u8 Glyph, image Dest, rect DestRect,
+          color_pair *ColorPair, b32 Bilinear)
+{
+    if (GlyphCacheSlot)
+    {
+        Assert(GlyphCacheSlot->TileDim.X == DestRect.Width && GlyphCacheSlot->TileDim.Y == DestRect.Height);
+        Assert(GlyphCacheSlot->Bilinear == Bilinear);
+        BlitCoverage(GlobalBlitPath, GetGlyphCoverage(GlyphCacheSlot, Glyph), Dest, DestRect,
+                     GetBlitColors(ColorPair));
+    }
+    else
+    {
+        rect SourceRect = GetGlyphSourceRect(FontAtlas, Glyph);
+        BlitAlphaColorPair(GlobalBlitPath, FontAtlas.Image, SourceRect, Dest, DestRect, ColorPair, Bilinear);
+    }
+}
+
+//
+// NOTE: Palette
+//
+
+void
+InitPalette(palette *Palette, memory_arena *Arena)
+{
+    *Palette = {};
+    Palette->ColorPairs = MemoryArena_PushArray(Arena, PaletteMaxColorPairs, color_pair);
+}
+
+// NOTE: Returns the index of the pair, reusing an existing one if the colors match. Meant to be called when
+// setting up, not per entity.
+u16
+AddColorPair(palette *Palette, vec3 Background, vec3 Foreground)
+{
+    u32 PackedBackground = PackColor(Background);
+    u32 PackedForeground = PackColor(Foreground);
+
+    for (u32 PairI = 0;
+         PairI < Palette->ColorPairCount;
+         ++PairI)
+    {
+        color_pair *ColorPair = Palette->ColorPairs + PairI;
+        if (ColorPair->Background == PackedBackground && ColorPair->Foreground == PackedForeground)
+        {
+            return (u16) PairI;
+        }
+    }
+
+    Assert(Palette->ColorPairCount < PaletteMaxColorPairs);
+    u16 Result = (u16) Palette->ColorPairCount++;
+    InitColorPair(Palette->ColorPairs + Result, PackedBackground, PackedForeground);
+
+    return Result;
+}
+
+inline color_pair *
+GetColorPair(palette *Palette, u16 ColorPair)
+{
+    Assert(ColorPair < Palette->ColorPairCount);
+    color_pair *Result = Palette->ColorPairs + ColorPair;
+    return Result;
+}
+
+//
+// NOTE: Fills. Spans of at least FillStreamMinWidth pixels use non-temporal stores, nothing reads them again before
+// the present, so there's no point in pulling them through the cache.
+//
+
+#define FillStreamMinWidth 256
+
+internal void
+FillRectScalar(image Dest, blit_clip Clip, u32 Color)
+{
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+        for (i32 ColumnI = Clip.MinX;
+             ColumnI < Clip.MaxX;
+             ++ColumnI)
+        {
+            *DestPixel++ = Color;
+        }
+    }
+}
+
+internal void
+FillRectSSE2(image Dest, blit_clip Clip, u32 Color)
+{
+    __m128i Color4 = _mm_set1_epi32((i32) Color);
+    i32 Count = Clip.MaxX - Clip.MinX;
+    b32 Stream = (Count >= FillStreamMinWidth);
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        i32 I = 0;
+        if (Stream)
+        {
+            // NOTE: Streaming stores have to be aligned
+            for (;
+                 I < Count && ((size_t) DestPixel & 15);
+                 ++I)
+            {
+                *DestPixel++ = Color;
+            }
+
+            for (;
+                 I + 4 <= Count;
+                 I += 4)
+            {
+                _mm_stream_si128((__m128i *) DestPixel, Color4);
+                DestPixel += 4;
+            }
+        }
+        else
+        {
+            for (;
+                 I + 4 <= Count;
+                 I += 4)
+            {
+                _mm_storeu_si128((__m128i *) DestPixel, Color4);
+                DestPixel += 4;
+            }
+        }
+
+        for (;
+             I < Count;
+             ++I)
+        {
+            *DestPixel++ = Color;
+        }
+    }
+
+    if (Stream)
+    {
+        _mm_sfence();
+    }
+}
+
+SAVOUR_TARGET_AVX2 internal void
+FillRectAVX2(image Dest, blit_clip Clip, u32 Color)
+{
+    __m256i Color8 = _mm256_set1_epi32((i32) Color);
+    i32 Count = Clip.MaxX - Clip.MinX;
+    b32 Stream = (Count >= FillStreamMinWidth);
+
+    for (i32 RowI = Clip.MinY;
+         RowI < Clip.MaxY;
+         ++RowI)
+    {
+        u32 *DestPixel = GetImageRow(Dest, RowI) + Clip.MinX;
+
+        i32 I = 0;
+        if (Stream)
+        {
+            // NOTE: Streaming stores have to be aligned
+            for (;
+                 I < Count && ((size_t) DestPixel & 31);
+                 ++I)
+            {
+                *DestPixel++ = Color;
+            }
+
+            for (;
+                 I + 8 <= Count;
+                 I += 8)
+            {
+                _mm256_stream_si256((__m256i *) DestPixel, Color8);
+                DestPixel += 8;
+            }
+        }
+        else
+        {
+            for (;
+                 I + 8 <= Count;
+                 I += 8)
+            {
+                _mm256_storeu_si256((__m256i *) DestPixel, Color8);
+                DestPixel += 8;
+            }
+        }
+
+        for (;
+             I < Count;
+             ++I)
+        {
+            *DestPixel++ = Color;
+        }
+    }
+
+    if (Stream)
+    {
+        _mm_sfence();
+    }
+}
+
+void
+FillRect(blit_path BlitPath, image Dest, rect DestRect, u32 Color)
+{
+    blit_clip Clip;
+    if (!ClipBlitDestRect(Dest, DestRect, &Clip))
+    {
+        return;
+    }
+
+    switch (BlitPath)
+    {
+        case BlitPath_Reference:
+        case BlitPath_Scalar:
+        {
+            FillRectScalar(Dest, Clip, Color);
+        } break;
+        case BlitPath_SSE2:
+        {
+            FillRectSSE2(Dest, Clip, Color);
+        } break;
+        case BlitPath_AVX2:
+        {
+            FillRectAVX2(Dest, Clip, Color);
+        } break;
+        default:
+        {
+            InvalidCodePath;
+        } break;
+    }
+}
+
+//
+// NOTE: Cell grid
+//
+
+void
+InitCellGrid(cell_grid *Grid, memory_arena *Arena, vec2i ScreenDim, vec2i MinTileDim)
+{
+    *Grid = {};
+
+    // NOTE: One partial cell on each side, plus one extra when the origin lands exactly on a tile edge
+    i32 MaxWidth = ScreenDim.X / MinTileDim.X + 2;
+    i32 MaxHeight = ScreenDim.Y / MinTileDim.Y + 2;
+    Grid->CellCapacity = (u32) (MaxWidth * MaxHeight);
+    Grid->Current = MemoryArena_PushArrayAndZero(Arena, Grid->CellCapacity, screen_cell);
+    Grid->Drawn = MemoryArena_PushArrayAndZero(Arena, Grid->CellCapacity, screen_cell);
+    Grid->IsDirty = MemoryArena_PushArrayAndZero(Arena, Grid->CellCapacity, u8);
+    Grid->DirtyRectCapacity = (u32) MaxHeight;
+    Grid->DirtyRects = MemoryArena_PushArrayAndZero(Arena, Grid->DirtyRectCapacity, platform_rect);
+    Grid->RedrawAll = true;
+}
+
+inline i32
+PositiveModulo(i32 A, i32 B)
+{
+    i32 Result = A % B;
+    if (Result < 0)
+    {
+        Result += B;
+    }
+    return Result;
+}
+
+// NOTE: TileOffset is the pixel position (before the Y flip) of any tile, all other tiles are on the same grid
+void
+BeginCellGrid(cell_grid *Grid, vec2i ScreenDim, vec2i TileDim, vec2i TileOffset)
+{
+    vec2i Origin = Vec2I(PositiveModulo(TileOffset.X, TileDim.X) - TileDim.X,
+                         PositiveModulo(TileOffset.Y, TileDim.Y) - TileDim.Y);
+    i32 Width = (ScreenDim.X - Origin.X + TileDim.X - 1) / TileDim.X;
+    i32 Height = (ScreenDim.Y - Origin.Y + TileDim.Y - 1) / TileDim.Y;
+    Assert((u32) (Width * Height) <= Grid->CellCapacity);
+
+    // NOTE: Different layout, so cells in Drawn don't line up with the new ones anymore
+    if (Width != Grid->Width || Height != Grid->Height ||
+        TileDim.X != Grid->TileDim.X || TileDim.Y != Grid->TileDim.Y)
+    {
+        Grid->RedrawAll = true;
+    }
+
+    Grid->Width = Width;
+    Grid->Height = Height;
+    Grid->TileDim = TileDim;
+    Grid->Origin = Origin;
+
+    for (i32 CellY = 0;
+         CellY < Height;
+         ++CellY)
+    {
+        for (i32 CellX = 0;
+             CellX < Width;
+             ++CellX)
+        {
+            screen_cell *Cell = Grid->Current + CellY * Width + CellX;
+            Cell->Rect.X = Origin.X + CellX * TileDim.X;
+            Cell->Rect.Y = Origin.Y + CellY * TileDim.Y;
+            Cell->Rect.Width = TileDim.X;
+            Cell->Rect.Height = TileDim.Y;
+            Cell->IsOccupied = false;
+        }
+    }
+}
+
+// NOTE: Later pushes into the same cell replace earlier ones. Tiles outside of the screen are dropped.
+void
+PushCell(cell_grid *Grid, rect DestRect, u8 Glyph, u16 ColorPair)
+{
+    Assert(DestRect.Width == Grid->TileDim.X && DestRect.Height == Grid->TileDim.Y);
+
+    i32 RelX = DestRect.X - Grid->Origin.X;
+    i32 RelY = DestRect.Y - Grid->Origin.Y;
+    if (RelX < 0 || RelY < 0)
+    {
+        return;
+    }
+
+    i32 CellX = RelX / Grid->TileDim.X;
+    i32 CellY = RelY / Grid->TileDim.Y;
+    if (CellX >= Grid->Width || CellY >= Grid->Height)
+    {
+        return;
+    }
+
+    screen_cell *Cell = Grid->Current + CellY * Grid->Width + CellX;
+    Assert(Cell->Rect.X == DestRect.X && Cell->Rect.Y == DestRect.Y);
+    Cell->IsOccupied = true;
+    Cell->Glyph = Glyph;
+    Cell->ColorPair = ColorPair;
+}
+
+inline b32
+CellsAreEqual(screen_cell *A, screen_cell *B)
+{
+    b32 Result = (A->Rect.X == B->Rect.X && A->Rect.Y == B->Rect.Y &&
+                  A->Rect.Width == B->Rect.Width && A->Rect.Height == B->Rect.Height &&
+                  A->IsOccupied == B->IsOccupied);
+
+    if (Result && A->IsOccupied)
+    {
+        Result = (A->Glyph == B->Glyph && A->ColorPair == B->ColorPair);
+    }
+
+    return Result;
+}
+
+// NOTE: Pixel row of the top of a row of cells, after the Y flip
+inline i32
+GetCellRowScreenY(cell_grid *Grid, i32 CellY, i32 ScreenHeight)
+{
+    i32 Result = ScreenHeight - (Grid->Origin.Y + CellY * Grid->TileDim.Y) - Grid->TileDim.Y;
+    return Result;
+}
+
+// NOTE: Draws the dirty cells of every BandStride-th band starting at FirstBand. Each band gets its own view of the
+// screen, so blits are clipped to it and bands never touch each other's pixels.
+internal void
+RenderCellBands(platform_work_queue *Queue, void *Data)
+{
+    cell_band_job *Job = (cell_band_job *) Data;
+    cell_grid *Grid = Job->Grid;
+    image Screen = Job->ScreenImage;
+
+    for (u32 BandI = Job->FirstBand;
+         BandI < Job->BandCount;
+         BandI += Job->BandStride)
+    {
+        i32 BandMinY = (i32) BandI * Job->BandHeight;
+        i32 BandMaxY = Min(BandMinY + Job->BandHeight, Screen.Height);
+        if (BandMinY >= BandMaxY)
+        {
+            continue;
+        }
+
+        image Band = Screen;
+        Band.Pixels = GetImageRow(Screen, BandMinY);
+        Band.Height = BandMaxY - BandMinY;
+
+        for (i32 CellY = 0;
+             CellY < Grid->Height;
+             ++CellY)
+        {
+            i32 RowMinY = GetCellRowScreenY(Grid, CellY, Screen.Height);
+            if (RowMinY >= BandMaxY || RowMinY + Grid->TileDim.Y <= BandMinY)
+            {
+                continue;
+            }
+
+            // NOTE: Only what no tile covers gets cleared. Runs of empty cells are merged, so a fully empty row of
+            // the screen is a single wide fill.
+            rect ClearRect = {};
+            for (i32 CellX = 0;
+                 CellX < Grid->Width;
+                 ++CellX)
+            {
+                u32 CellI = (u32) (CellY * Grid->Width + CellX);
+                screen_cell *Cell = Grid->Current + CellI;
+                rect Rect = Cell->Rect;
+                Rect.Y = RowMinY - BandMinY;
+
+                if (Grid->IsDirty[CellI] && !Cell->IsOccupied)
+                {
+                    if (ClearRect.Width)
+                    {
+                        ClearRect.Width += Rect.Width;
+                    }
+                    else
+                    {
+                        ClearRect = Rect;
+                    }
+                    continue;
+                }
+
+                if (ClearRect.Width)
+                {
+                    FillRect(GlobalBlitPath, Band, ClearRect, ScreenClearColor);
+                    ClearRect.Width = 0;
+                }
+
+                if (Grid->IsDirty[CellI])
+                {
+                    DrawGlyph(Job->FontAtlas, Job->GlyphCacheSlot, Cell->Glyph, Band, Rect,
+                              GetColorPair(Job->Palette, Cell->ColorPair), Job->Bilinear);
+                }
+            }
+
+            if (ClearRect.Width)
+            {
+                FillRect(GlobalBlitPath, Band, ClearRect, ScreenClearColor);
+            }
+        }
+    }
+}
+
+// NOTE: A rect over the dirty cells of every row of cells, from the leftmost to the rightmost one, with rows that
+// span the same columns merged into the rect above them
+internal void
+CollectDirtyRects(cell_grid *Grid, i32 ScreenWidth, i32 ScreenHeight)
+{
+    Grid->DirtyRectCount = 0;
+
+    i32 PreviousMinCellX = -1;
+    i32 PreviousMaxCellX = -1;
+    for (i32 CellY = 0;
+         CellY < Grid->Height;
+         ++CellY)
+    {
+        i32 MinCellX = -1;
+        i32 MaxCellX = -1;
+        for (i32 CellX = 0;
+             CellX < Grid->Width;
+             ++CellX)
+        {
+            if (Grid->IsDirty[CellY * Grid->Width + CellX])
+            {
+                if (MinCellX < 0)
+                {
+                    MinCellX = CellX;
+                }
+                MaxCellX = CellX;
+            }
+        }
+
+        // NOTE: Rows of cells go up the screen, so a row's rect sits right above the previous one
+        i32 MinY = Max(GetCellRowScreenY(Grid, CellY, ScreenHeight), 0);
+        i32 MaxY = Min(GetCellRowScreenY(Grid, CellY, ScreenHeight) + Grid->TileDim.Y, ScreenHeight);
+        i32 MinX = Max(Grid->Origin.X + MinCellX * Grid->TileDim.X, 0);
+        i32 MaxX = Min(Grid->Origin.X + (MaxCellX + 1) * Grid->TileDim.X, ScreenWidth);
+        if (MinCellX >= 0 && MinY < MaxY && MinX < MaxX)
+        {
+            if (MinCellX == PreviousMinCellX && MaxCellX == PreviousMaxCellX)
+            {
+                platform_rect *Rect = Grid->DirtyRects + Grid->DirtyRectCount - 1;
+                Rect->Height += Rect->Y - MinY;
+                Rect->Y = MinY;
+            }
+            else
+            {
+                Assert(Grid->DirtyRectCount < Grid->DirtyRectCapacity);
+                platform_rect *Rect = Grid->DirtyRects + Grid->DirtyRectCount++;
+                Rect->X = MinX;
+                Rect->Y = MinY;
+                Rect->Width = MaxX - MinX;
+                Rect->Height = MaxY - MinY;
+            }
+            PreviousMinCellX = MinCellX;
+            PreviousMaxCellX = MaxCellX;
+        }
+        else
+        {
+            PreviousMinCellX = -1;
+            PreviousMaxCellX = -1;
+        }
+    }
+}
+
+// NOTE: Rasterizes the cells that changed since they were last drawn, split into horizontal bands over ThreadCount
+// threads. The output doesn't depend on ThreadCount.
+void
+ResolveCellGrid(cell_grid *Grid, palette *Palette, font_atlas FontAtlas, glyph_cache_slot *GlyphCacheSlot,
+                b32 Bilinear, image ScreenImage, platform_work_queue *Queue, u32 ThreadCount)
+{
+    Grid->CellsRedrawn = 0;
+
+    u32 CellCount = (u32) (Grid->Width * Grid->Height);
+    for (u32 CellI = 0;
+         CellI < CellCount;
+         ++CellI)
+    {
+        b32 IsDirty = (Grid->RedrawAll || !CellsAreEqual(Grid->Current + CellI, Grid->Drawn + CellI));
+        Grid->IsDirty[CellI] = (u8) IsDirty;
+        if (IsDirty)
+        {
+            Grid->CellsRedrawn++;
+        }
+    }
+    CollectDirtyRects(Grid, ScreenImage.Width, ScreenImage.Height);
+
+    if (Grid->CellsRedrawn)
+    {
+        ThreadCount = Max(1, Min(ThreadCount, CellBandMaxJobCount));
+        u32 BandCount = ThreadCount * CellBandsPerThread;
+
+        cell_band_job Jobs[CellBandMaxJobCount];
+        for (u32 JobI = 0;
+             JobI < ThreadCount;
+             ++JobI)
+        {
+            cell_band_job *Job = Jobs + JobI;
+            Job->Grid = Grid;
+            Job->Palette = Palette;
+            Job->FontAtlas = FontAtlas;
+            Job->GlyphCacheSlot = GlyphCacheSlot;
+            Job->Bilinear = Bilinear;
+            Job->ScreenImage = ScreenImage;
+            Job->FirstBand = JobI;
+            Job->BandStride = ThreadCount;
+            Job->BandCount = BandCount;
+            Job->BandHeight = (ScreenImage.Height + (i32) BandCount - 1) / (i32) BandCount;
+        }
+
+        if (ThreadCount == 1)
+        {
+            RenderCellBands(Queue, Jobs);
+        }
+        else
+        {
+            for (u32 JobI = 0;
+                 JobI < ThreadCount;
+                 ++JobI)
+            {
+                Platform_AddWorkEntry(Queue, RenderCellBands, Jobs + JobI);
+            }
+            Platform_CompleteAllWork(Queue);
+        }
+
+        for (u32 CellI = 0;
+             CellI < CellCount;
+             ++CellI)
+        {
+            if (Grid->IsDirty[CellI])
+            {
+                Grid->Drawn[CellI] = Grid->Current[CellI];
+            }
+        }
+    }
+
+    Grid->RedrawAll = false;
+}
+
+//
+// NOTE: Render commands
+//
+
+render_commands
+BeginRenderCommands(memory_arena *Arena, u32 MaxTileCount, vec2i ScreenDim, vec2i TileDim, vec2i TileOrigin,
+                    b32 Bilinear)
+{
+    render_commands Result = {};
+
+    Result.ScreenDim = ScreenDim;
+    Result.TileDim = TileDim;
+    Result.TileOrigin = TileOrigin;
+    Result.Bilinear = Bilinear;
+    Result.MaxTileCount = MaxTileCount;
+    Result.Tiles = MemoryArena_PushArray(Arena, MaxTileCount, render_tile_command);
+    Result.SortedTiles = MemoryArena_PushArray(Arena, MaxTileCount, render_tile_command);
+
+    return Result;
+}
+
+// NOTE: Tiles that end up completely off screen are dropped right away
+void
+PushTile(render_commands *Commands, vec2i TileP, u8 Glyph, u16 ColorPair, render_layer Layer)
+{
+    i32 PxX = Commands->TileOrigin.X + TileP.X * Commands->TileDim.X;
+    i32 PxY = Commands->TileOrigin.Y + TileP.Y * Commands->TileDim.Y;
+    if (PxX + Commands->TileDim.X <= 0 || PxX >= Commands->ScreenDim.X ||
+        PxY + Commands->TileDim.Y <= 0 || PxY >= Commands->ScreenDim.Y)
+    {
+        return;
+    }
+
+    Assert(Commands->TileCount < Commands->MaxTileCount);
+    Assert(TileP.X >= -32768 && TileP.X <= 32767 && TileP.Y >= -32768 && TileP.Y <= 32767);
+
+    render_tile_command *Tile = Commands->Tiles + Commands->TileCount++;
+    Tile->X = (i16) TileP.X;
+    Tile->Y = (i16) TileP.Y;
+    Tile->Glyph = Glyph;
+    Tile->Layer = (u8) Layer;
+    Tile->ColorPair = ColorPair;
+}
+
+// NOTE: Stable counting sort by layer into SortedTiles
+internal void
+SortRenderCommandsByLayer(render_commands *Commands)
+{
+    u32 LayerFirst[RenderLayer_Count] = {};
+    for (u32 TileI = 0;
+         TileI < Commands->TileCount;
+         ++TileI)
+    {
+        Assert(Commands->Tiles[TileI].Layer < RenderLayer_Count);
+        LayerFirst[Commands->Tiles[TileI].Layer]++;
+    }
+
+    u32 Total = 0;
+    for (u32 LayerI = 0;
+         LayerI < RenderLayer_Count;
+         ++LayerI)
+    {
+        u32 Count = LayerFirst[LayerI];
+        LayerFirst[LayerI] = Total;
+        Total += Count;
+    }
+
+    for (u32 TileI = 0;
+         TileI < Commands->TileCount;
+         ++TileI)
+    {
+        render_tile_command *Tile = Commands->Tiles + TileI;
+        Commands->SortedTiles[LayerFirst[Tile->Layer]++] = *Tile;
+    }
+}
+
+//
+// NOTE: Software renderer
+//
+
+// NOTE: MinTileDim is the smallest tile size that will ever be rendered, it decides how many cells there can be
+void
+InitSoftwareRenderer(software_renderer *Renderer, memory_arena *Arena, vec2i ScreenDim, vec2i MinTileDim)
+{
+    InitGlyphCache(&Renderer->GlyphCache, Arena);
+    InitCellGrid(&Renderer->CellGrid, Arena, ScreenDim, MinTileDim);
+}
+
+void
+SoftwareRenderCommands(software_renderer *Renderer, render_commands *Commands, font_atlas *FontAtlas, palette *Palette,
+                       image ScreenImage, platform_work_queue *Queue, u32 ThreadCount)
+{
+    Assert(Commands->ScreenDim.X == ScreenImage.Width && Commands->ScreenDim.Y == ScreenImage.Height);
+
+    // NOTE: Glyphs pre-scaled to the tile size from the closest mip, only rebuilt when the zoom changes
+    font_atlas MipFontAtlas = GetFontAtlasMip(FontAtlas, ChooseFontAtlasMip(FontAtlas, Commands->TileDim));
+    glyph_cache_slot *GlyphCacheSlot = GetGlyphCacheSlot(&Renderer->GlyphCache, &MipFontAtlas, Commands->TileDim,
+                                                         Commands->Bilinear);
+
+    SortRenderCommandsByLayer(Commands);
+
+    cell_grid *CellGrid = &Renderer->CellGrid;
+    BeginCellGrid(CellGrid, Commands->ScreenDim, Commands->TileDim, Commands->TileOrigin);
+
+    rect DestRect = {};
+    DestRect.Width = Commands->TileDim.X;
+    DestRect.Height = Commands->TileDim.Y;
+    for (u32 TileI = 0;
+         TileI < Commands->TileCount;
+         ++TileI)
+    {
+        render_tile_command *Tile = Commands->SortedTiles + TileI;
+        DestRect.X = Commands->TileOrigin.X + Tile->X * Commands->TileDim.X;
+        DestRect.Y = Commands->TileOrigin.Y + Tile->Y * Commands->TileDim.Y;
+        PushCell(CellGrid, DestRect, Tile->Glyph, Tile->ColorPair);
+    }
+
+    ResolveCellGrid(CellGrid, Palette, MipFontAtlas, GlyphCacheSlot, Commands->Bilinear, ScreenImage,
+                    Queue, ThreadCount);
+}
+
+#if SAVOUR_INTERNAL
+//
+// NOTE: Checks every fixed point path against the scalar one, bit for bit, and the scalar one against the float
+// reference. They sample the same texels, but the reference truncates the float colors and both blend terms
+// separately while the fixed point paths round once, so against it each channel may be off by
+// BlitReferenceTolerance. Bilinear also quantizes the weights to 8 bits, which can cost one more.
+//
+#define BlitReferenceTolerance 2
+#define BilinearReferenceTolerance 3
+
+internal inline i32
+GetMaxChannelDelta(u32 A, u32 B)
+{
+    i32 Result = 0;
+    for (u32 Shift = 0;
+         Shift < 32;
+         Shift += 8)
+    {
+        i32 Delta = (i32) ((A >> Shift) & 0xFF) - (i32) ((B >> Shift) & 0xFF);
+        if (Delta < 0)
+        {
+            Delta = -Delta;
+        }
+        Result = Max(Result, Delta);
+    }
+    return Result;
+}
+
+void
+DEBUG_ValidateBlitPaths(font_atlas FontAtlas, memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    image Images[BlitPath_Count];
+    for (u32 PathI = 0;
+         PathI < BlitPath_Count;
+         ++PathI)
+    {
+        Images[PathI].Width = 2 * FontAtlas.GlyphPxWidth * 10 + 7;
+        Images[PathI].Height = 2 * FontAtlas.GlyphPxHeight * 10 + 7;
+        Images[PathI].Pitch = Images[PathI].Width * 4;
+        Images[PathI].Pixels = MemoryArena_PushArray(TransientArena, Images[PathI].Width * Images[PathI].Height, u32);
+    }
+
+    b32 HasSSE2 = Platform_HasSSE2();
+    b32 HasAVX2 = Platform_HasAVX2();
+
+    vec3 Bg = Vec3(0.3f, 0.6f, 0.4f);
+    vec3 Fg = Vec3(0.4f, 0.7f, 0.4f);
+
+    u32 PixelCount = 0;
+
+    for (u32 Bilinear = 0;
+         Bilinear <= 1;
+         ++Bilinear)
+    {
+        i32 Tolerance = Bilinear ? BilinearReferenceTolerance : BlitReferenceTolerance;
+
+        // NOTE: Tile sizes over the whole zoom range, with odd offsets so that clipping on every side gets hit
+        for (i32 TileWidth = 3;
+             TileWidth <= FontAtlas.GlyphPxWidth * 10;
+             TileWidth += 7)
+        {
+            i32 TileHeight = TileWidth * FontAtlas.GlyphPxHeight / FontAtlas.GlyphPxWidth;
+            u8 Glyph = (u8) (TileWidth * 37);
+            rect SourceRect = GetGlyphSourceRect(FontAtlas, Glyph);
+
+            rect DestRects[] =
+            {
+                { 5, 3, TileWidth, TileHeight },
+                { -TileWidth / 3, -TileHeight / 2, TileWidth, TileHeight },
+                { Images[0].Width - TileWidth / 2, Images[0].Height - TileHeight / 3, TileWidth, TileHeight },
+            };
+
+            for (u32 DestRectI = 0;
+                 DestRectI < ArrayCount(DestRects);
+                 ++DestRectI)
+            {
+                for (u32 PathI = 0;
+                     PathI < BlitPath_Count;
+                     ++PathI)
+                {
+                    if ((PathI == BlitPath_SSE2 && !HasSSE2) ||
+                        (PathI == BlitPath_AVX2 && !HasAVX2))
+                    {
+                        continue;
+                    }
+                    BlitAlpha((blit_path) PathI, FontAtlas.Image, SourceRect, Images[PathI], DestRects[DestRectI], Bg, Fg, Bilinear);
+                }
+
+                blit_clip Clip;
+                if (!ClipBlitDestRect(Images[0], DestRects[DestRectI], &Clip))
+                {
+                    continue;
+                }
+
+                for (i32 Y = Clip.MinY;
+                     Y < Clip.MaxY;
+                     ++Y)
+                {
+                    for (i32 X = Clip.MinX;
+                         X < Clip.MaxX;
+                         ++X)
+                    {
+                        i32 PixelIndex = Y * Images[0].Width + X;
+                        u32 Scalar = ((u32 *) Images[BlitPath_Scalar].Pixels)[PixelIndex];
+                        u32 Reference = ((u32 *) Images[BlitPath_Reference].Pixels)[PixelIndex];
+
+                        if (HasSSE2)
+                        {
+                            Assert(((u32 *) Images[BlitPath_SSE2].Pixels)[PixelIndex] == Scalar);
+                        }
+                        if (HasAVX2)
+                        {
+                            Assert(((u32 *) Images[BlitPath_AVX2].Pixels)[PixelIndex] == Scalar);
+                        }
+
+                        Assert(GetMaxChannelDelta(Scalar, Reference) <= Tolerance);
+                        PixelCount++;
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Blit paths validated over %u px.\n", PixelCount);
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+
+// NOTE: Cached glyphs are sampled exactly like BlitAlpha does, so they have to come out bit for bit the same as
+// blitting from the atlas, for every path
+void
+DEBUG_ValidateGlyphCache(font_atlas FontAtlas, memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    image Expected;
+    Expected.Width = 256;
+    Expected.Height = 256;
+    Expected.Pitch = Expected.Width * 4;
+    Expected.Pixels = MemoryArena_PushArray(TransientArena, Expected.Width * Expected.Height, u32);
+    image Actual = Expected;
+    Actual.Pixels = MemoryArena_PushArray(TransientArena, Actual.Width * Actual.Height, u32);
+
+    glyph_cache_slot Slot = {};
+    Slot.Coverage = MemoryArena_PushArray(TransientArena, 256 * GlyphCacheMaxTilePx, u8);
+
+    b32 HasSSE2 = Platform_HasSSE2();
+    b32 HasAVX2 = Platform_HasAVX2();
+
+    color_pair ColorPair;
+    InitColorPair(&ColorPair, PackColor(Vec3(0.2f, 0.2f, 0.6f)), PackColor(Vec3(0.3f, 0.3f, 0.8f)));
+    blit_colors Colors = GetBlitColors(&ColorPair);
+
+    for (u32 Bilinear = 0;
+         Bilinear <= 1;
+         ++Bilinear)
+    {
+        for (i32 TileWidth = 1;
+             TileWidth <= 96;
+             TileWidth += 5)
+        {
+            vec2i TileDim = Vec2I(TileWidth, TileWidth * FontAtlas.GlyphPxHeight / FontAtlas.GlyphPxWidth);
+            if (TileDim.Y <= 0 || TileDim.X * TileDim.Y > GlyphCacheMaxTilePx)
+            {
+                continue;
+            }
+            BuildGlyphCacheSlot(&Slot, &FontAtlas, TileDim, Bilinear);
+
+            rect DestRects[] =
+            {
+                { 1, 2, TileDim.X, TileDim.Y },
+                { -TileDim.X / 2, -TileDim.Y / 3, TileDim.X, TileDim.Y },
+                { Expected.Width - TileDim.X / 3, Expected.Height - TileDim.Y / 2, TileDim.X, TileDim.Y },
+            };
+
+            for (u32 Glyph = 0;
+                 Glyph < 256;
+                 Glyph += 13)
+            {
+                for (u32 DestRectI = 0;
+                     DestRectI < ArrayCount(DestRects);
+                     ++DestRectI)
+                {
+                    rect DestRect = DestRects[DestRectI];
+                    BlitAlpha(BlitPath_Scalar, FontAtlas.Image, GetGlyphSourceRect(FontAtlas, (u8) Glyph), Expected, DestRect,
+                              Vec3(0.2f, 0.2f, 0.6f), Vec3(0.3f, 0.3f, 0.8f), Bilinear);
+
+                    for (u32 PathI = BlitPath_Scalar;
+                         PathI < BlitPath_Count;
+                         ++PathI)
+                    {
+                        if ((PathI == BlitPath_SSE2 && !HasSSE2) ||
+                            (PathI == BlitPath_AVX2 && !HasAVX2))
+                        {
+                            continue;
+                        }
+                        BlitCoverage((blit_path) PathI, GetGlyphCoverage(&Slot, (u8) Glyph), Actual, DestRect, Colors);
+
+                        blit_clip Clip;
+                        if (ClipBlitDestRect(Expected, DestRect, &Clip))
+                        {
+                            for (i32 Y = Clip.MinY;
+                                 Y < Clip.MaxY;
+                                 ++Y)
+                            {
+                                for (i32 X = Clip.MinX;
+                                     X < Clip.MaxX;
+                                     ++X)
+                                {
+                                    i32 PixelIndex = Y * Expected.Width + X;
+                                    Assert(((u32 *) Actual.Pixels)[PixelIndex] == ((u32 *) Expected.Pixels)[PixelIndex]);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Glyph cache validated.\n");
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+
+// NOTE: Captures this frame's commands and replays them as full redraws with 1 to MaxThreadCount threads, without
+// any of the game logic. Every thread count has to produce exactly the same frame as a single thread.
+void
+DEBUG_BenchmarkRenderCommands(software_renderer *Renderer, render_commands *Commands, font_atlas *FontAtlas,
+                              palette *Palette, image ScreenImage, platform_work_queue *Queue, u32 MaxThreadCount,
+                              memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    render_commands Captured = BeginRenderCommands(TransientArena, Commands->TileCount, Commands->ScreenDim,
+                                                   Commands->TileDim, Commands->TileOrigin, Commands->Bilinear);
+    for (u32 TileI = 0;
+         TileI < Commands->TileCount;
+         ++TileI)
+    {
+        Captured.Tiles[TileI] = Commands->Tiles[TileI];
+    }
+    Captured.TileCount = Commands->TileCount;
+
+    u32 PixelCount = (u32) (ScreenImage.Width * ScreenImage.Height);
+    u32 *Expected = MemoryArena_PushArray(TransientArena, PixelCount, u32);
+
+    u32 RunCount = 16;
+    for (u32 ThreadCount = 1;
+         ThreadCount <= MaxThreadCount;
+         ++ThreadCount)
+    {
+        f64 StartSeconds = Platform_GetSeconds();
+        for (u32 RunI = 0;
+             RunI < RunCount;
+             ++RunI)
+        {
+            Renderer->CellGrid.RedrawAll = true;
+            SoftwareRenderCommands(Renderer, &Captured, FontAtlas, Palette, ScreenImage, Queue, ThreadCount);
+        }
+        f64 ElapsedSeconds = Platform_GetSeconds() - StartSeconds;
+
+        for (i32 Y = 0;
+             Y < ScreenImage.Height;
+             ++Y)
+        {
+            u32 *Row = GetImageRow(ScreenImage, Y);
+            u32 *ExpectedRow = Expected + Y * ScreenImage.Width;
+            for (i32 X = 0;
+                 X < ScreenImage.Width;
+                 ++X)
+            {
+                if (ThreadCount == 1)
+                {
+                    ExpectedRow[X] = Row[X];
+                }
+                else
+                {
+                    Assert(ExpectedRow[X] == Row[X]);
+                }
+            }
+        }
+
+        printf("Render commands: %u tiles, %u thread(s), %0.3fms per full redraw\n",
+               Captured.TileCount, ThreadCount, 1000.0 * ElapsedSeconds / RunCount);
+    }
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+
+// NOTE: Nearest against bilinear at TileDim, drawing a screen full of glyphs. Tiles that fit the glyph cache are drawn
+// from it, like the game does, after rebuilding a slot, and for comparison also straight from the atlas.
+void
+DEBUG_BenchmarkGlyphFilters(font_atlas FontAtlas, vec2i TileDim, vec2i ScreenDim, memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    image Screen;
+    Screen.Width = ScreenDim.X;
+    Screen.Height = ScreenDim.Y;
+    Screen.Pitch = Screen.Width * 4;
+    Screen.Pixels = MemoryArena_PushArray(TransientArena, Screen.Width * Screen.Height, u32);
+
+    b32 IsCached = (TileDim.X * TileDim.Y <= GlyphCacheMaxTilePx);
+    glyph_cache_slot Slot = {};
+    Slot.Coverage = MemoryArena_PushArray(TransientArena, 256 * GlyphCacheMaxTilePx, u8);
+
+    color_pair ColorPair;
+    InitColorPair(&ColorPair, PackColor(Vec3(0.3f, 0.6f, 0.4f)), PackColor(Vec3(0.4f, 0.7f, 0.4f)));
+
+    f64 AtlasMs[2] = {};
+    f64 CachedMs[2] = {};
+    f64 RebuildMs[2] = {};
+    u32 RunCount = 8;
+    for (u32 Bilinear = 0;
+         Bilinear <= 1;
+         ++Bilinear)
+    {
+        if (IsCached)
+        {
+            f64 StartSeconds = Platform_GetSeconds();
+            BuildGlyphCacheSlot(&Slot, &FontAtlas, TileDim, Bilinear);
+            RebuildMs[Bilinear] = 1000.0 * (Platform_GetSeconds() - StartSeconds);
+        }
+
+        for (u32 FromAtlas = 0;
+             FromAtlas <= 1;
+             ++FromAtlas)
+        {
+            if (!FromAtlas && !IsCached)
+            {
+                continue;
+            }
+
+            f64 StartSeconds = Platform_GetSeconds();
+            for (u32 RunI = 0;
+                 RunI < RunCount;
+                 ++RunI)
+            {
+                for (i32 Y = 0;
+                     Y < Screen.Height;
+                     Y += TileDim.Y)
+                {
+                    for (i32 X = 0;
+                         X < Screen.Width;
+                         X += TileDim.X)
+                    {
+                        u8 Glyph = (u8) (X * 7 + Y * 13);
+                        rect DestRect = { X, Y, TileDim.X, TileDim.Y };
+                        if (FromAtlas)
+                        {
+                            BlitAlphaColorPair(GlobalBlitPath, FontAtlas.Image, GetGlyphSourceRect(FontAtlas, Glyph),
+                                               Screen, DestRect, &ColorPair, Bilinear);
+                        }
+                        else
+                        {
+                            DrawGlyph(FontAtlas, &Slot, Glyph, Screen, DestRect, &ColorPair, Bilinear);
+                        }
+                    }
+                }
+            }
+            f64 Ms = 1000.0 * (Platform_GetSeconds() - StartSeconds) / RunCount;
+            if (FromAtlas)
+            {
+                AtlasMs[Bilinear] = Ms;
+            }
+            else
+            {
+                CachedMs[Bilinear] = Ms;
+            }
+        }
+    }
+
+    printf("Glyph filters at %dx%d from %dx%d glyphs, nearest/bilinear per screen:", TileDim.X, TileDim.Y,
+           FontAtlas.GlyphPxWidth, FontAtlas.GlyphPxHeight);
+    if (IsCached)
+    {
+        printf(" cached %0.3f/%0.3fms (%0.2fx, slot rebuild %0.3f/%0.3fms),",
+               CachedMs[0], CachedMs[1], CachedMs[1] / CachedMs[0], RebuildMs[0], RebuildMs[1]);
+    }
+    printf(" from atlas %0.3f/%0.3fms (%0.2fx)\n", AtlasMs[0], AtlasMs[1], AtlasMs[1] / AtlasMs[0]);
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+#endif
@@ -0,0 +1,226 @@
+#ifndef SAVOUR_RENDER_H
+#define SAVOUR_RENDER_H
+
+#include "and_common.h"
+#include "and_linmath.h"
+
+#include "savour_platform.h"
+
+struct image
+{
+    i32 Width;
+    i32 Height;
+    // NOTE: Bytes from one row to the next, at least Width * 4
+    i32 Pitch;
+    void *Pixels;
+};
+
+struct rect
+{
+    i32 X;
+    i32 Y;
+    i32 Width;
+    i32 Height;
+};
+
+inline image GetImageFromPlatformImage(platform_image PlatformImage)
+{
+    image Result = {};
+
+    Result.Width = PlatformImage.Width;
+    Result.Height = PlatformImage.Height;
+    Result.Pitch = PlatformImage.Pitch;
+    Result.Pixels = PlatformImage.ImageData;
+
+    return Result;
+}
+
+inline u32 *GetImageRow(image Image, i32 Y)
+{
+    u32 *Result = (u32 *) ((u8 *) Image.Pixels + (size_t) Y * Image.Pitch);
+    return Result;
+}
+
+// NOTE: MipImages are box filtered halvings of Image, MipImages[0] being Image itself. They stop while every glyph
+// cell still halves evenly, so no texel ever straddles two glyphs.
+#define FontAtlasMaxMipCount 8
+
+struct font_atlas
+{
+    image Image;
+    i32 AtlasWidth;
+    i32 AtlasHeight;
+    i32 GlyphPxWidth;
+    i32 GlyphPxHeight;
+
+    u32 MipCount;
+    image MipImages[FontAtlasMaxMipCount];
+};
+
+// NOTE: Which implementation BlitAlpha dispatches to. Reference is the original float
+// implementation, kept around to validate the others against.
+enum blit_path
+{
+    BlitPath_Reference,
+    BlitPath_Scalar,
+    BlitPath_SSE2,
+    BlitPath_AVX2,
+
+    BlitPath_Count,
+};
+
+// NOTE: Destination rect clipped to the destination image. Min inclusive, max exclusive.
+struct blit_clip
+{
+    i32 MinX;
+    i32 MinY;
+    i32 MaxX;
+    i32 MaxY;
+};
+
+// NOTE: Two colors that are drawn together, packed like the screen pixels (R << 24 | G << 16 | B << 8 | A). The
+// blended pixel for every atlas alpha value is precomputed, so blending a texel is a single lookup. Entities and
+// screen cells refer to pairs by their index in the palette.
+struct color_pair
+{
+    u32 Background;
+    u32 Foreground;
+    u32 BlendTable[256];
+};
+
+#define PaletteMaxColorPairs 256
+
+struct palette
+{
+    u32 ColorPairCount;
+    color_pair *ColorPairs;
+};
+
+// NOTE: Colors unpacked to 8 bit per channel for the SIMD blend kernels, the scalar ones use the blend table
+struct blit_colors
+{
+    u8 BgR, BgG, BgB;
+    u8 FgR, FgG, FgB;
+    u32 *BlendTable;
+};
+
+// NOTE: All 256 glyphs of the font atlas pre-scaled to one tile size, as 8 bit coverage masks. A few tile sizes are
+// kept around so zooming back and forth doesn't rebuild every frame. Tiles bigger than GlyphCacheMaxTilePx are
+// rare enough (very zoomed in, few tiles on screen) that they are blitted from the atlas directly.
+#define GlyphCacheSlotCount 4
+#define GlyphCacheMaxTilePx (96 * 144)
+
+struct glyph_cache_slot
+{
+    vec2i TileDim;
+    b32 Bilinear;
+    u64 LastUsed;
+    u8 *Coverage;
+};
+
+struct glyph_cache
+{
+    glyph_cache_slot Slots[GlyphCacheSlotCount];
+    u64 UseCounter;
+    u32 RebuildCount;
+};
+
+// NOTE: Screen split into tile sized cells, remembering what was last drawn into each one. Every frame the tiles are
+// pushed into Current, and only cells that differ from Drawn get rasterized again. Cells nothing was pushed into
+// are cleared, so the grid always owns every pixel of the screen and nothing else needs to clear it.
+#define ScreenClearColor 0xFF0000FF
+
+struct screen_cell
+{
+    rect Rect;
+    b32 IsOccupied;
+    u8 Glyph;
+    u16 ColorPair;
+};
+
+struct cell_grid
+{
+    u32 CellCapacity;
+    screen_cell *Current;
+    screen_cell *Drawn;
+    u8 *IsDirty;
+
+    i32 Width;
+    i32 Height;
+    vec2i TileDim;
+    // NOTE: Top-left of cell (0, 0) in pixels, before the Y flip. Always in (-TileDim, 0].
+    vec2i Origin;
+
+    b32 RedrawAll;
+    u32 CellsRedrawn;
+
+    // NOTE: What the last resolve drew into, a rect per run of rows of cells with the same dirty columns, clipped to
+    // the screen
+    u32 DirtyRectCapacity;
+    u32 DirtyRectCount;
+    platform_rect *DirtyRects;
+};
+
+// NOTE: A few bands per thread, handed out round robin, so a band full of changed cells doesn't leave the other
+// threads idle
+#define CellBandsPerThread 4
+#define CellBandMaxJobCount 64
+
+struct cell_band_job
+{
+    cell_grid *Grid;
+    palette *Palette;
+    font_atlas FontAtlas;
+    glyph_cache_slot *GlyphCacheSlot;
+    b32 Bilinear;
+    image ScreenImage;
+
+    u32 FirstBand;
+    u32 BandStride;
+    u32 BandCount;
+    i32 BandHeight;
+};
+
+// NOTE: The game describes a frame as a list of tile draws, which a renderer then turns into pixels on its own.
+// Tiles are in tile units from TileOrigin, the pixel position (before the Y flip) of tile (0, 0). In each cell the
+// highest layer wins, and within a layer the tile pushed last.
+enum render_layer
+{
+    RenderLayer_Terrain,
+    RenderLayer_Entities,
+    RenderLayer_Debug,
+
+    RenderLayer_Count,
+};
+
+struct render_tile_command
+{
+    i16 X;
+    i16 Y;
+    u8 Glyph;
+    u8 Layer;
+    u16 ColorPair;
+};
+
+struct render_commands
+{
+    vec2i ScreenDim;
+    vec2i TileDim;
+    vec2i TileOrigin;
+    b32 Bilinear;
+
+    u32 TileCount;
+    u32 MaxTileCount;
+    render_tile_command *Tiles;
+    // NOTE: Room for the renderer to sort the tiles by layer
+    render_tile_command *SortedTiles;
+};
+
+// NOTE: Everything the software renderer keeps between frames
+struct software_renderer
+{
+    glyph_cache GlyphCache;
+    cell_grid CellGrid;
+};
+
+#endif
@@ -0,0 +1,2488 @@
+//
+// NOTE: Tile types
+//
+
+u16
+AddTileType(tile_type_table *Table, u8 Glyph, u8 VariantGlyph, u16 ColorPair, b32 IsBlocking, b32 IsOpaque)
+{
+    Assert(Table->Count < TileTypeMaxCount);
+
+    tile_type *Type = Table->Types + Table->Count;
+    Type->Glyphs[0] = Glyph;
+    Type->Glyphs[1] = VariantGlyph;
+    Type->ColorPair = ColorPair;
+    Type->IsBlocking = IsBlocking;
+    Type->IsOpaque = IsOpaque;
+
+    return (u16) Table->Count++;
+}
+
+inline u16
+MakeTileId(u16 TileType, u32 Variant)
+{
+    Assert(Variant < 2);
+    u16 Result = (u16) ((TileType << 1) | Variant);
+    return Result;
+}
+
+inline u16
+GetTileTypeIndex(u16 TileId)
+{
+    u16 Result = (u16) (TileId >> 1);
+    return Result;
+}
+
+inline tile_type *
+GetTileType(tile_type_table *Table, u16 TileId)
+{
+    Assert((u32) (TileId >> 1) < Table->Count);
+    tile_type *Result = Table->Types + (TileId >> 1);
+    return Result;
+}
+
+inline u8
+GetTileGlyph(tile_type_table *Table, u16 TileId)
+{
+    u8 Result = GetTileType(Table, TileId)->Glyphs[TileId & 1];
+    return Result;
+}
+
+//
+// NOTE: Tile positions
+//
+
+inline i32
+GetChunkFromTile(i32 Tile, i32 ChunkDim)
+{
+    Assert(INT_MIN + ChunkDim <= Tile);
+    
+    if (Tile < 0)
+    {
+        Tile -= ChunkDim - 1;
+    }
+
+    i32 Result = Tile / ChunkDim;
+    return Result;
+}
+
+inline i32
+GetLeftmostTileFromChunk(i32 Chunk, i32 ChunkDim)
+{
+    i32 Tile = Chunk * ChunkDim;
+    return Tile;
+}
+
+inline vec3i
+GetChunkPFromTileP(vec3i TileP, vec3i ChunkDim)
+{
+    vec3i ChunkP = Vec3I(GetChunkFromTile(TileP.X, ChunkDim.X),
+                         GetChunkFromTile(TileP.Y, ChunkDim.Y),
+                         GetChunkFromTile(TileP.Z, ChunkDim.Z));
+    return ChunkP;
+}
+
+inline vec3i
+GetLeftmostTilePFromChunkP(vec3i ChunkP, vec3i ChunkDim)
+{
+    vec3i TileP = Vec3I(GetLeftmostTileFromChunk(ChunkP.X, ChunkDim.X),
+                        GetLeftmostTileFromChunk(ChunkP.Y, ChunkDim.Y),
+                        GetLeftmostTileFromChunk(ChunkP.Z, ChunkDim.Z));
+    return TileP;
+}
+
+//
+// NOTE: Chunk table
+//
+
+inline u32
+HashChunkP(vec3i P)
+{
+    u32 Hash = ((u32) P.X * 0x8DA6B343u) ^ ((u32) P.Y * 0xD8163841u) ^ ((u32) P.Z * 0xCB1AB31Fu);
+
+    // NOTE: Murmur3 finalizer, neighbouring chunks mostly differ in the low bits of X and Y
+    Hash ^= Hash >> 16;
+    Hash *= 0x85EBCA6Bu;
+    Hash ^= Hash >> 13;
+    Hash *= 0xC2B2AE35u;
+    Hash ^= Hash >> 16;
+
+    return Hash;
+}
+
+internal void
+AllocateChunkTableEntries(chunk_table *Table, u32 Capacity)
+{
+    Assert(Capacity && (Capacity & (Capacity - 1)) == 0);
+    Table->Capacity = Capacity;
+    Table->Count = 0;
+    Table->Entries = MemoryArena_PushArrayAndZero(Table->Arena, Capacity, chunk_table_entry);
+}
+
+void
+InitChunkTable(chunk_table *Table, memory_arena *Arena, u32 InitialCapacity)
+{
+    Table->Arena = Arena;
+    AllocateChunkTableEntries(Table, InitialCapacity);
+}
+
+// NOTE: Index of the entry holding P, or of the empty entry where P would go
+internal u32
+FindChunkTableSlot(chunk_table *Table, vec3i P)
+{
+    u32 Mask = Table->Capacity - 1;
+    u32 Index = HashChunkP(P) & Mask;
+    for (;;)
+    {
+        chunk_table_entry *Entry = Table->Entries + Index;
+        if (!Entry->Chunk || Vec3IAreEqual(Entry->P, P))
+        {
+            return Index;
+        }
+        Index = (Index + 1) & Mask;
+    }
+}
+
+chunk *
+GetChunk(chunk_table *Table, vec3i P)
+{
+    chunk *Result = Table->Entries[FindChunkTableSlot(Table, P)].Chunk;
+    return Result;
+}
+
+internal void
+GrowChunkTable(chunk_table *Table)
+{
+    u32 OldCapacity = Table->Capacity;
+    chunk_table_entry *OldEntries = Table->Entries;
+
+    AllocateChunkTableEntries(Table, 2 * OldCapacity);
+    for (u32 EntryI = 0;
+         EntryI < OldCapacity;
+         ++EntryI)
+    {
+        chunk_table_entry *OldEntry = OldEntries + EntryI;
+        if (OldEntry->Chunk)
+        {
+            Table->Entries[FindChunkTableSlot(Table, OldEntry->P)] = *OldEntry;
+            Table->Count++;
+        }
+    }
+}
+
+void
+InsertChunk(chunk_table *Table, vec3i P, chunk *Chunk)
+{
+    Assert(Chunk);
+
+    if ((Table->Count + 1) * ChunkTableMaxLoadDenominator > Table->Capacity * ChunkTableMaxLoadNumerator)
+    {
+        GrowChunkTable(Table);
+    }
+
+    chunk_table_entry *Entry = Table->Entries + FindChunkTableSlot(Table, P);
+    Assert(!Entry->Chunk);
+    Entry->P = P;
+    Entry->Chunk = Chunk;
+    Table->Count++;
+}
+
+chunk *
+RemoveChunk(chunk_table *Table, vec3i P)
+{
+    u32 Mask = Table->Capacity - 1;
+    u32 Index = FindChunkTableSlot(Table, P);
+    chunk *Result = Table->Entries[Index].Chunk;
+    if (!Result)
+    {
+        return 0;
+    }
+
+    // NOTE: Pull back every following entry of the run that wouldn't be found past the hole anymore
+    u32 Hole = Index;
+    u32 NextIndex = (Index + 1) & Mask;
+    while (Table->Entries[NextIndex].Chunk)
+    {
+        u32 Home = HashChunkP(Table->Entries[NextIndex].P) & Mask;
+        b32 HomeIsPastHole = (((NextIndex - Home) & Mask) < ((NextIndex - Hole) & Mask));
+        if (!HomeIsPastHole)
+        {
+            Table->Entries[Hole] = Table->Entries[NextIndex];
+            Hole = NextIndex;
+        }
+        NextIndex = (NextIndex + 1) & Mask;
+    }
+
+    Table->Entries[Hole].Chunk = 0;
+    Table->Count--;
+
+    return Result;
+}
+
+//
+// NOTE: Terrain
+//
+
+noise_layer
+NoiseLayer(f32 Period, f32 Lacunarity, f32 Gain, u32 Octaves, u64 Seed)
+{
+    Assert(Octaves <= PerlinMaxOctaves);
+
+    noise_layer Result = {};
+    Result.Period = Period;
+    Result.Lacunarity = Lacunarity;
+    Result.Gain = Gain;
+    Result.Octaves = Octaves;
+    Result.Spacing = 1;
+    Result.Seed = Seed;
+    SeedPerlinNoise(&Result.Noise, Seed);
+    return Result;
+}
+
+// NOTE: Samples the layer as sparsely as it can while staying within MaxError of sampling every tile
+void
+SetNoiseLayerMaxError(noise_layer *Layer, f32 MaxError)
+{
+    Layer->Spacing = PerlinChooseCoarseSpacing(&Layer->Noise, Layer->Period, Layer->Lacunarity, Layer->Gain,
+                                               Layer->Octaves, MaxError);
+}
+
+inline void
+SampleNoiseLayer(noise_layer *Layer, f32 *Samples, i32 Width, i32 Height, i32 X0, i32 Y0)
+{
+    PerlinSampleOctavesCoarseGrid(&Layer->Noise, Samples, Width, Height, X0, Y0, Layer->Period, Layer->Lacunarity,
+                                  Layer->Gain, Layer->Octaves, Layer->Spacing);
+}
+
+// NOTE: Both intensities normalized to 0-1
+inline u16
+GetTerrainTileType(world_generator *Generator, f32 ContinentalIntensity, f32 Intensity)
+{
+    u16 Result;
+    if (ContinentalIntensity < 0.5f || Intensity <= 0.4f)
+    {
+        // NOTE: Water
+        Result = Generator->WaterTileType;
+    }
+    else if (Intensity >= 0.6f)
+    {
+        // NOTE: Mountain
+        Result = Generator->MountainTileType;
+    }
+    else
+    {
+        // NOTE: Grass
+        Result = Generator->GrassTileType;
+    }
+    return Result;
+}
+
+// NOTE: Random has to be seeded with SeedChunkRandom, and carried over from the rows before FirstRow
+void
+GenerateChunkRows(world_generator *Generator, vec3i ChunkP, u16 *Tiles, random_state *Random,
+                  i32 FirstRow, i32 OnePastLastRow)
+{
+    vec3i ChunkDim = Generator->ChunkDim;
+    vec3i FirstTileP = Vec3I(ChunkP.X * ChunkDim.X, ChunkP.Y * ChunkDim.Y, ChunkP.Z * ChunkDim.Z);
+
+    i32 RowCount = OnePastLastRow - FirstRow;
+    Assert(ChunkDim.X * RowCount <= ChunkTileCount);
+    f32 ContinentalIntensities[ChunkTileCount];
+    f32 Intensities[ChunkTileCount];
+    SampleNoiseLayer(&Generator->Continental, ContinentalIntensities, ChunkDim.X, RowCount,
+                     FirstTileP.X, FirstTileP.Y + FirstRow);
+    SampleNoiseLayer(&Generator->Terrain, Intensities, ChunkDim.X, RowCount, FirstTileP.X, FirstTileP.Y + FirstRow);
+
+    for (i32 I = FirstRow * ChunkDim.X;
+         I < OnePastLastRow * ChunkDim.X;
+         ++I)
+    {
+        f32 ContinentalIntensity = PerlinNormalize(ContinentalIntensities[I - FirstRow * ChunkDim.X]);
+        f32 Intensity = PerlinNormalize(Intensities[I - FirstRow * ChunkDim.X]);
+
+        u32 Variant = GetRandomU32(Random) & 1;
+        Tiles[I] = MakeTileId(GetTerrainTileType(Generator, ContinentalIntensity, Intensity), Variant);
+    }
+}
+
+// NOTE: Every chunk draws from its own PCG stream, picked by the chunk position and started from the world seed. So a
+// chunk comes out the same on whichever thread it's generated, in however many steps, and when it's generated again
+// after being evicted, and nothing is shared between chunks generated at the same time.
+inline void
+SeedChunkRandom(random_state *Random, u64 Seed, vec3i ChunkP)
+{
+    u64 Stream = (((u64) (u32) ChunkP.X << 32) | (u32) ChunkP.Y) + (u64) (u32) ChunkP.Z * 0x9E3779B97F4A7C15ull;
+    SeedRandom(Random, Seed + HashChunkP(ChunkP), Stream);
+}
+
+void
+GenerateChunkTiles(world_generator *Generator, vec3i ChunkP, u16 *Tiles)
+{
+    random_state Random;
+    SeedChunkRandom(&Random, Generator->Seed, ChunkP);
+    GenerateChunkRows(Generator, ChunkP, Tiles, &Random, 0, Generator->ChunkDim.Y);
+}
+
+//
+// NOTE: Region files
+//
+
+void
+InitRegionStore(region_store *Store, const char *Directory, region_storage Storage, world_generator *Generator,
+                platform_work_queue *WorkQueue)
+{
+    Store->Directory = SimpleString(Directory);
+    Store->Storage = Storage;
+    Store->Generator = Generator;
+    Store->WorkQueue = WorkQueue;
+    Platform_CreateDirectory(Directory);
+
+    Store->Batches[0].Store = Store;
+    Store->Batches[1].Store = Store;
+    Store->Pending = Store->Batches;
+}
+
+inline i32
+GetRegionFromChunk(i32 Chunk)
+{
+    i32 Result = ((Chunk < 0) ? (Chunk - (RegionDim - 1)) : Chunk) / RegionDim;
+    return Result;
+}
+
+inline vec3i
+GetRegionPFromChunkP(vec3i ChunkP)
+{
+    vec3i Result = Vec3I(GetRegionFromChunk(ChunkP.X), GetRegionFromChunk(ChunkP.Y), ChunkP.Z);
+    return Result;
+}
+
+// NOTE: Index of the chunk's entry in its region's offset table
+inline u32
+GetChunkIndexInRegion(vec3i ChunkP)
+{
+    vec3i RegionP = GetRegionPFromChunkP(ChunkP);
+    u32 Result = (u32) ((ChunkP.Y - RegionP.Y * RegionDim) * RegionDim + (ChunkP.X - RegionP.X * RegionDim));
+    return Result;
+}
+
+inline simple_string
+GetRegionPath(region_store *Store, vec3i RegionP)
+{
+    simple_string Result = SimpleStringF("%s/%d.%d.%d.region", Store->Directory.D, RegionP.X, RegionP.Y, RegionP.Z);
+    return Result;
+}
+
+inline b32
+IsRegionHeaderValid(region_file_header *Header, region_store *Store)
+{
+    b32 Result = (Header->Magic == RegionFileMagic && Header->Version == RegionFileVersion &&
+                  Header->TilesPerChunk == ChunkTileCount && Header->Storage == (u32) Store->Storage &&
+                  Header->Seed == Store->Generator->Seed && Header->GeneratorVersion == WorldGeneratorVersion);
+    return Result;
+}
+
+// NOTE: Maps the region file if it isn't already, taking the slot of the region mapped longest ago
+internal mapped_region *
+GetMappedRegion(region_store *Store, vec3i RegionP)
+{
+    for (u32 RegionI = 0;
+         RegionI < RegionCacheCount;
+         ++RegionI)
+    {
+        mapped_region *Region = Store->Regions + RegionI;
+        if (Region->IsUsed && Vec3IAreEqual(Region->P, RegionP))
+        {
+            return Region;
+        }
+    }
+
+    mapped_region *Region = Store->Regions + Store->NextRegionSlot;
+    Store->NextRegionSlot = (Store->NextRegionSlot + 1) % RegionCacheCount;
+
+    Platform_UnmapFile(&Region->File);
+    Region->IsUsed = true;
+    Region->P = RegionP;
+    Region->File = Platform_MapFile(GetRegionPath(Store, RegionP).D);
+
+    // NOTE: Files from an older version, another seed or generator, with the other storage, or cut short, are as good
+    // as none
+    region_file_header *Header = (region_file_header *) Region->File.Data;
+    if (Header && (Region->File.Size < sizeof(region_file_header) || !IsRegionHeaderValid(Header, Store)))
+    {
+        Platform_UnmapFile(&Region->File);
+    }
+
+    return Region;
+}
+
+internal void
+UnmapRegion(region_store *Store, vec3i RegionP)
+{
+    for (u32 RegionI = 0;
+         RegionI < RegionCacheCount;
+         ++RegionI)
+    {
+        mapped_region *Region = Store->Regions + RegionI;
+        if (Region->IsUsed && Vec3IAreEqual(Region->P, RegionP))
+        {
+            Platform_UnmapFile(&Region->File);
+            Region->IsUsed = false;
+        }
+    }
+}
+
+inline void
+CopyChunkTiles(u16 *Dest, u16 *Source)
+{
+    for (u32 TileI = 0;
+         TileI < ChunkTileCount;
+         ++TileI)
+    {
+        Dest[TileI] = Source[TileI];
+    }
+}
+
+internal region_write *
+FindUnwrittenChunk(region_write_batch *Batch, vec3i ChunkP)
+{
+    // NOTE: Newest first, a chunk can be saved more than once before the batch is written
+    for (u32 WriteI = Batch->Count;
+         WriteI > 0;
+         --WriteI)
+    {
+        region_write *Write = Batch->Writes + WriteI - 1;
+        if (Vec3IAreEqual(Write->ChunkP, ChunkP))
+        {
+            return Write;
+        }
+    }
+
+    return 0;
+}
+
+// NOTE: The chunk's record in the mapped region file, 0 when there's none. Size is how much of the mapping there is
+// from the record on.
+internal u8 *
+GetChunkRecord(region_store *Store, vec3i ChunkP, u64 *Out_Size)
+{
+    u8 *Result = 0;
+
+    mapped_region *Region = GetMappedRegion(Store, GetRegionPFromChunkP(ChunkP));
+    region_file_header *Header = (region_file_header *) Region->File.Data;
+    if (Header)
+    {
+        u64 Offset = Header->ChunkOffsets[GetChunkIndexInRegion(ChunkP)];
+        // NOTE: An entry past the end of the mapping belongs to a batch that's still being written, the chunk is
+        // still in Store->Writing
+        if (Offset && Offset < Region->File.Size)
+        {
+            Result = (u8 *) Header + Offset;
+            *Out_Size = Region->File.Size - Offset;
+        }
+    }
+
+    return Result;
+}
+
+internal region_write *
+FindUnwrittenChunk(region_store *Store, vec3i ChunkP)
+{
+    // NOTE: The pending batch is newer than the one being written
+    region_write *Result = FindUnwrittenChunk(Store->Pending, ChunkP);
+    if (!Result && Store->Writing)
+    {
+        Result = FindUnwrittenChunk(Store->Writing, ChunkP);
+    }
+    return Result;
+}
+
+// NOTE: False when the chunk has to be generated, because it was never saved, or because the store only keeps edits,
+// which ApplyChunkEdits puts on top once it's generated. Chunks saved but not written yet are always loaded whole.
+b32
+LoadChunk(region_store *Store, vec3i ChunkP, u16 *Tiles)
+{
+    b32 Result = false;
+
+    region_write *Unwritten = FindUnwrittenChunk(Store, ChunkP);
+    if (Unwritten)
+    {
+        CopyChunkTiles(Tiles, Unwritten->Tiles);
+        Result = true;
+    }
+    else if (Store->Storage == RegionStorage_Tiles)
+    {
+        u64 RecordSize;
+        u16 *Record = (u16 *) GetChunkRecord(Store, ChunkP, &RecordSize);
+        if (Record && RecordSize >= ChunkTileCount * sizeof(u16))
+        {
+            CopyChunkTiles(Tiles, Record);
+            Result = true;
+        }
+    }
+
+    if (Result)
+    {
+        Store->LoadedCount++;
+    }
+
+    return Result;
+}
+
+// NOTE: Tiles being the chunk fresh from the generator. Does nothing when the store keeps whole chunks.
+void
+ApplyChunkEdits(region_store *Store, vec3i ChunkP, u16 *Tiles)
+{
+    if (Store->Storage == RegionStorage_Edits)
+    {
+        u64 RecordSize;
+        u8 *Record = GetChunkRecord(Store, ChunkP, &RecordSize);
+        if (Record && RecordSize >= sizeof(u32))
+        {
+            u32 EditCount = *(u32 *) Record;
+            region_tile_edit *Edits = (region_tile_edit *) (Record + sizeof(u32));
+            if (EditCount <= ChunkTileCount && sizeof(u32) + EditCount * sizeof(region_tile_edit) <= RecordSize)
+            {
+                for (u32 EditI = 0;
+                     EditI < EditCount;
+                     ++EditI)
+                {
+                    region_tile_edit Edit = Edits[EditI];
+                    if (Edit.TileIndex < ChunkTileCount)
+                    {
+                        Tiles[Edit.TileIndex] = Edit.Tile;
+                    }
+                }
+                Store->LoadedCount++;
+            }
+        }
+    }
+}
+
+// NOTE: Copies the tiles into the pending batch. False, and nothing saved, when the batch is full.
+b32
+SaveChunk(region_store *Store, vec3i ChunkP, u16 *Tiles)
+{
+    region_write_batch *Batch = Store->Pending;
+    if (Batch->Count == RegionWriteBatchMaxCount)
+    {
+        return false;
+    }
+
+    region_write *Write = Batch->Writes + Batch->Count++;
+    Write->ChunkP = ChunkP;
+    CopyChunkTiles(Write->Tiles, Tiles);
+
+    return true;
+}
+
+// NOTE: How many bytes the record at Offset takes up, 0 when it can't be read
+internal u32
+GetRegionRecordSize(region_store *Store, platform_file *File, u32 Offset)
+{
+    u32 Result = (u32) (ChunkTileCount * sizeof(u16));
+    if (Store->Storage == RegionStorage_Edits)
+    {
+        u32 EditCount = 0;
+        Result = 0;
+        if (Platform_ReadFile(File, Offset, &EditCount, sizeof(EditCount)) && EditCount <= ChunkTileCount)
+        {
+            Result = (u32) (sizeof(u32) + EditCount * sizeof(region_tile_edit));
+        }
+    }
+    return Result;
+}
+
+inline b32
+IsRegionPLess(vec3i A, vec3i B)
+{
+    b32 Result = (A.Z != B.Z) ? (A.Z < B.Z) : (A.Y != B.Y) ? (A.Y < B.Y) : (A.X < B.X);
+    return Result;
+}
+
+// NOTE: Any thread. Sorted by region, so each file is opened once for the batch.
+internal void
+WriteRegionBatch(region_write_batch *Batch)
+{
+    region_store *Store = Batch->Store;
+
+    u16 Order[RegionWriteBatchMaxCount];
+    vec3i RegionPs[RegionWriteBatchMaxCount];
+    for (u32 WriteI = 0;
+         WriteI < Batch->Count;
+         ++WriteI)
+    {
+        RegionPs[WriteI] = GetRegionPFromChunkP(Batch->Writes[WriteI].ChunkP);
+
+        // NOTE: Insertion sort, stable so later saves of a chunk still get written later
+        u32 J = WriteI;
+        while (J > 0 && IsRegionPLess(RegionPs[WriteI], RegionPs[Order[J - 1]]))
+        {
+            Order[J] = Order[J - 1];
+            --J;
+        }
+        Order[J] = (u16) WriteI;
+    }
+
+    u32 WriteI = 0;
+    while (WriteI < Batch->Count)
+    {
+        vec3i RegionP = RegionPs[Order[WriteI]];
+        simple_string Path = GetRegionPath(Store, RegionP);
+        platform_file File = Platform_OpenFile(Path.D);
+
+        // NOTE: A new file, or one we can't read, gets a fresh header. Records of an old one are left where they
+        // are, nothing points at them anymore.
+        region_file_header Header = {};
+        if (File.IsOpen &&
+            (File.Size < sizeof(region_file_header) ||
+             !Platform_ReadFile(&File, 0, &Header, sizeof(Header)) ||
+             !IsRegionHeaderValid(&Header, Store)))
+        {
+            Header = {};
+            Header.Magic = RegionFileMagic;
+            Header.Version = RegionFileVersion;
+            Header.TilesPerChunk = ChunkTileCount;
+            Header.Storage = Store->Storage;
+            Header.Seed = Store->Generator->Seed;
+            Header.GeneratorVersion = WorldGeneratorVersion;
+            u64 HeaderEnd = Max(File.Size, (u64) sizeof(region_file_header));
+            Platform_WriteFile(&File, 0, &Header, sizeof(Header));
+            File.Size = HeaderEnd;
+        }
+
+        for (;
+             WriteI < Batch->Count && Vec3IAreEqual(RegionPs[Order[WriteI]], RegionP);
+             ++WriteI)
+        {
+            region_write *Write = Batch->Writes + Order[WriteI];
+            if (File.IsOpen)
+            {
+                void *Record = Write->Tiles;
+                u32 RecordSize = sizeof(Write->Tiles);
+
+                // NOTE: A u32 count and the edits right after it
+                u32 EditRecord[1 + ChunkTileCount];
+                if (Store->Storage == RegionStorage_Edits)
+                {
+                    u16 GeneratedTiles[ChunkTileCount];
+                    GenerateChunkTiles(Store->Generator, Write->ChunkP, GeneratedTiles);
+
+                    u32 EditCount = 0;
+                    region_tile_edit *Edits = (region_tile_edit *) (EditRecord + 1);
+                    for (u32 TileI = 0;
+                         TileI < ChunkTileCount;
+                         ++TileI)
+                    {
+                        if (Write->Tiles[TileI] != GeneratedTiles[TileI])
+                        {
+                            Edits[EditCount].TileIndex = (u16) TileI;
+                            Edits[EditCount].Tile = Write->Tiles[TileI];
+                            EditCount++;
+                        }
+                    }
+                    EditRecord[0] = EditCount;
+
+                    // NOTE: No edits left, the entry is cleared and the chunk goes back to being generated
+                    Record = EditCount ? EditRecord : 0;
+                    RecordSize = sizeof(u32) + EditCount * sizeof(region_tile_edit);
+                }
+
+                u32 ChunkI = GetChunkIndexInRegion(Write->ChunkP);
+                u32 OldOffset = Header.ChunkOffsets[ChunkI];
+                u32 OldSize = OldOffset ? GetRegionRecordSize(Store, &File, OldOffset) : 0;
+
+                u32 RecordOffset = 0;
+                if (Record)
+                {
+                    u64 Offset = (OldSize && RecordSize <= OldSize) ? OldOffset : File.Size;
+                    // NOTE: Entries are u32, a record that would end past 4GB can't be pointed at. The save fails
+                    // and the entry keeps pointing at the old record.
+                    if (Offset + RecordSize > (u64) 0xFFFFFFFF)
+                    {
+                        printf("Regions: %s is full, chunk (%d, %d, %d) not saved\n", Path.D,
+                               Write->ChunkP.X, Write->ChunkP.Y, Write->ChunkP.Z);
+                        continue;
+                    }
+                    if (!Platform_WriteFile(&File, Offset, Record, RecordSize))
+                    {
+                        continue;
+                    }
+                    RecordOffset = (u32) Offset;
+                }
+
+                if (RecordOffset != OldOffset)
+                {
+                    u64 EntryOffset = offsetof(region_file_header, ChunkOffsets) + ChunkI * sizeof(u32);
+                    if (!Platform_WriteFile(&File, EntryOffset, &RecordOffset, sizeof(RecordOffset)))
+                    {
+                        continue;
+                    }
+                    Header.ChunkOffsets[ChunkI] = RecordOffset;
+                }
+
+                if (OldSize)
+                {
+                    Header.DeadBytes += (RecordOffset == OldOffset) ? OldSize - RecordSize : OldSize;
+                }
+            }
+        }
+
+        if (File.IsOpen)
+        {
+            Platform_WriteFile(&File, offsetof(region_file_header, DeadBytes), &Header.DeadBytes,
+                               sizeof(Header.DeadBytes));
+
+            // NOTE: Compacted once more than half of the records are dead
+            u64 RecordBytes = File.Size - sizeof(region_file_header);
+            if (Header.DeadBytes >= RegionCompactMinDeadBytes && 2 * (u64) Header.DeadBytes > RecordBytes)
+            {
+                Batch->CompactRegionPs[Batch->CompactCount++] = RegionP;
+            }
+        }
+
+        Platform_CloseFile(&File);
+    }
+}
+
+// NOTE: Main thread only, with the region unmapped and no batch being written. Records are moved down over the dead
+// bytes before them in file order, each entry pointed at its record right after it's moved. A record is only ever
+// written over space that's dead or its own, so every entry points at a whole record at any point.
+internal void
+CompactRegionFile(region_store *Store, vec3i RegionP)
+{
+    platform_file File = Platform_OpenFile(GetRegionPath(Store, RegionP).D);
+
+    region_file_header Header;
+    if (File.IsOpen && File.Size >= sizeof(Header) && Platform_ReadFile(&File, 0, &Header, sizeof(Header)) &&
+        IsRegionHeaderValid(&Header, Store))
+    {
+        // NOTE: Insertion sort of the entries by where their record is
+        u16 Order[RegionChunkCount];
+        u32 OrderCount = 0;
+        for (u32 ChunkI = 0;
+             ChunkI < RegionChunkCount;
+             ++ChunkI)
+        {
+            u32 Offset = Header.ChunkOffsets[ChunkI];
+            if (Offset)
+            {
+                u32 J = OrderCount++;
+                while (J > 0 && Header.ChunkOffsets[Order[J - 1]] > Offset)
+                {
+                    Order[J] = Order[J - 1];
+                    --J;
+                }
+                Order[J] = (u16) ChunkI;
+            }
+        }
+
+        // NOTE: Stops at the first record that can't be moved, it and everything after stay where they are
+        u64 NextOffset = sizeof(region_file_header);
+        b32 AllMoved = true;
+        for (u32 OrderI = 0;
+             OrderI < OrderCount && AllMoved;
+             ++OrderI)
+        {
+            u32 ChunkI = Order[OrderI];
+            u32 Offset = Header.ChunkOffsets[ChunkI];
+            u32 RecordSize = GetRegionRecordSize(Store, &File, Offset);
+
+            u8 Record[sizeof(u32) + ChunkTileCount * sizeof(region_tile_edit)];
+            Assert(RecordSize <= sizeof(Record));
+            AllMoved = (RecordSize && Offset >= NextOffset && Platform_ReadFile(&File, Offset, Record, RecordSize));
+            if (AllMoved && Offset != NextOffset)
+            {
+                u32 NewOffset = (u32) NextOffset;
+                u64 EntryOffset = offsetof(region_file_header, ChunkOffsets) + ChunkI * sizeof(u32);
+                AllMoved = (Platform_WriteFile(&File, NewOffset, Record, RecordSize) &&
+                            Platform_WriteFile(&File, EntryOffset, &NewOffset, sizeof(NewOffset)));
+            }
+            NextOffset += RecordSize;
+        }
+
+        if (AllMoved)
+        {
+            Header.DeadBytes = 0;
+            if (Platform_WriteFile(&File, offsetof(region_file_header, DeadBytes), &Header.DeadBytes,
+                                   sizeof(Header.DeadBytes)))
+            {
+                Platform_SetFileSize(&File, NextOffset);
+            }
+        }
+    }
+
+    Platform_CloseFile(&File);
+}
+
+internal void
+WriteRegionBatchJob(platform_work_queue *WorkQueue, void *Data)
+{
+    region_write_batch *Batch = (region_write_batch *) Data;
+
+    WriteRegionBatch(Batch);
+
+    CompletePreviousWritesBeforeFutureWrites;
+    Batch->IsDone = true;
+}
+
+// NOTE: Main thread only, once per frame. Finishes the batch the writer is done with and hands it the pending one.
+void
+UpdateRegionWrites(region_store *Store)
+{
+    region_write_batch *Batch = Store->Writing;
+    if (Batch && Batch->IsDone)
+    {
+        CompletePreviousReadsBeforeFutureReads;
+
+        // NOTE: The files grew, they get mapped again with their new size
+        for (u32 WriteI = 0;
+             WriteI < Batch->Count;
+             ++WriteI)
+        {
+            UnmapRegion(Store, GetRegionPFromChunkP(Batch->Writes[WriteI].ChunkP));
+        }
+
+        // NOTE: Nothing has these mapped now, and nothing else is writing
+        for (u32 CompactI = 0;
+             CompactI < Batch->CompactCount;
+             ++CompactI)
+        {
+            CompactRegionFile(Store, Batch->CompactRegionPs[CompactI]);
+        }
+
+        Store->SavedCount += Batch->Count;
+        Batch->Count = 0;
+        Batch->CompactCount = 0;
+        Batch->IsDone = false;
+        Store->Writing = 0;
+    }
+
+    if (!Store->Writing && Store->Pending->Count)
+    {
+        Store->Writing = Store->Pending;
+        Store->Pending = (Store->Pending == Store->Batches) ? Store->Batches + 1 : Store->Batches;
+
+        if (Store->WorkQueue)
+        {
+            Platform_AddWorkEntry(Store->WorkQueue, WriteRegionBatchJob, Store->Writing);
+        }
+        else
+        {
+            WriteRegionBatch(Store->Writing);
+            Store->Writing->IsDone = true;
+        }
+    }
+}
+
+// NOTE: Main thread only. Returns once everything saved so far is on disk.
+void
+FlushRegionWrites(region_store *Store)
+{
+    while (Store->Writing || Store->Pending->Count)
+    {
+        if (Store->WorkQueue)
+        {
+            Platform_CompleteAllWork(Store->WorkQueue);
+        }
+        UpdateRegionWrites(Store);
+    }
+}
+
+//
+// NOTE: Cold chunks
+//
+
+void
+InitColdChunkStore(cold_chunk_store *Store, memory_arena *Arena, u32 BudgetBytes)
+{
+    Assert(BudgetBytes % ColdChunkAlignment == 0);
+    Assert(BudgetBytes >= 2 * (sizeof(cold_chunk_header) + ChunkTileCount * sizeof(u16)));
+    Store->BudgetBytes = BudgetBytes;
+    Store->Ring = MemoryArena_PushBytes(Arena, BudgetBytes);
+
+    Store->MaxCount = BudgetBytes / ColdChunkExpectedSize;
+    Store->IndexCapacity = 64;
+    while (Store->IndexCapacity * ChunkTableMaxLoadNumerator < Store->MaxCount * ChunkTableMaxLoadDenominator)
+    {
+        Store->IndexCapacity *= 2;
+    }
+    Store->Index = MemoryArena_PushArrayAndZero(Arena, Store->IndexCapacity, cold_chunk_index_entry);
+}
+
+// NOTE: Index of the index entry holding P, or of the empty one where P would go
+internal u32
+FindColdChunkSlot(cold_chunk_store *Store, vec3i P)
+{
+    u32 Mask = Store->IndexCapacity - 1;
+    u32 Index = HashChunkP(P) & Mask;
+    for (;;)
+    {
+        cold_chunk_index_entry *Entry = Store->Index + Index;
+        if (!Entry->OffsetPlusOne || Vec3IAreEqual(Entry->P, P))
+        {
+            return Index;
+        }
+        Index = (Index + 1) & Mask;
+    }
+}
+
+// NOTE: Same as RemoveChunk
+internal void
+RemoveColdChunkIndexEntry(cold_chunk_store *Store, u32 Index)
+{
+    u32 Mask = Store->IndexCapacity - 1;
+    u32 Hole = Index;
+    u32 NextIndex = (Index + 1) & Mask;
+    while (Store->Index[NextIndex].OffsetPlusOne)
+    {
+        u32 Home = HashChunkP(Store->Index[NextIndex].P) & Mask;
+        b32 HomeIsPastHole = (((NextIndex - Home) & Mask) < ((NextIndex - Hole) & Mask));
+        if (!HomeIsPastHole)
+        {
+            Store->Index[Hole] = Store->Index[NextIndex];
+            Hole = NextIndex;
+        }
+        NextIndex = (NextIndex + 1) & Mask;
+    }
+
+    Store->Index[Hole].OffsetPlusOne = 0;
+    Store->Count--;
+}
+
+internal void
+DropOldestColdChunk(cold_chunk_store *Store)
+{
+    Assert(Store->UsedBytes);
+    cold_chunk_header *Header = (cold_chunk_header *) (Store->Ring + Store->OldestOffset);
+
+    // NOTE: Padding at the end of the ring, and chunks taken out since, aren't in the index
+    u32 Slot = FindColdChunkSlot(Store, Header->P);
+    if (Store->Index[Slot].OffsetPlusOne == Store->OldestOffset + 1)
+    {
+        RemoveColdChunkIndexEntry(Store, Slot);
+        Store->LiveBytes -= Header->Size;
+        Store->DroppedCount++;
+    }
+
+    Store->OldestOffset += Header->Size;
+    if (Store->OldestOffset == Store->BudgetBytes)
+    {
+        Store->OldestOffset = 0;
+    }
+    Store->UsedBytes -= Header->Size;
+}
+
+// NOTE: Drops the oldest entries until Size bytes in a row are free at NextOffset
+internal void
+MakeRoomForColdChunk(cold_chunk_store *Store, u32 Size)
+{
+    for (;;)
+    {
+        if (!Store->UsedBytes)
+        {
+            Store->OldestOffset = 0;
+            Store->NextOffset = 0;
+        }
+
+        if (Store->NextOffset > Store->OldestOffset || !Store->UsedBytes)
+        {
+            u32 BytesToEnd = Store->BudgetBytes - Store->NextOffset;
+            if (BytesToEnd >= Size)
+            {
+                break;
+            }
+
+            // NOTE: Entries never wrap around, the rest of the ring becomes padding
+            if (BytesToEnd)
+            {
+                cold_chunk_header *Padding = (cold_chunk_header *) (Store->Ring + Store->NextOffset);
+                Padding->P = Vec3I();
+                Padding->Size = (u16) BytesToEnd;
+                Padding->PaletteCount = 0;
+                Store->UsedBytes += BytesToEnd;
+            }
+            Store->NextOffset = 0;
+        }
+        else
+        {
+            if (Store->OldestOffset - Store->NextOffset >= Size)
+            {
+                break;
+            }
+            DropOldestColdChunk(Store);
+        }
+    }
+}
+
+inline u32
+GetColdChunkBitsPerTile(u32 PaletteCount)
+{
+    u32 Result = 0;
+    while ((1u << Result) < PaletteCount)
+    {
+        Result++;
+    }
+    return Result;
+}
+
+// NOTE: The packed indices are read two bytes at a time, so there is one more byte than they take up
+inline u32
+GetColdChunkPackedSize(u32 BitsPerTile)
+{
+    u32 Result = BitsPerTile ? ((ChunkTileCount * BitsPerTile + 7) / 8 + 1) : 0;
+    return Result;
+}
+
+// NOTE: Main thread only. Replaces the oldest cold chunks when there's no room.
+void
+AddColdChunk(cold_chunk_store *Store, vec3i P, u16 *Tiles)
+{
+    u16 Palette[ChunkTileCount];
+    u8 Indices[ChunkTileCount];
+    u32 PaletteCount = 0;
+    u32 PaletteIndex = 0;
+    for (u32 TileI = 0;
+         TileI < ChunkTileCount;
+         ++TileI)
+    {
+        // NOTE: Neighbouring tiles are mostly the same, so try the last one first
+        if (!PaletteCount || Palette[PaletteIndex] != Tiles[TileI])
+        {
+            for (PaletteIndex = 0;
+                 PaletteIndex < PaletteCount && Palette[PaletteIndex] != Tiles[TileI];
+                 ++PaletteIndex)
+            {
+            }
+            if (PaletteIndex == PaletteCount)
+            {
+                Palette[PaletteCount++] = Tiles[TileI];
+            }
+        }
+        Indices[TileI] = (u8) PaletteIndex;
+    }
+
+    u32 BitsPerTile = GetColdChunkBitsPerTile(PaletteCount);
+    u32 PaletteSize = sizeof(cold_chunk_header) + PaletteCount * sizeof(u16) + GetColdChunkPackedSize(BitsPerTile);
+    u32 RawSize = sizeof(cold_chunk_header) + ChunkTileCount * sizeof(u16);
+    b32 IsRaw = (PaletteSize >= RawSize);
+    u32 Size = IsRaw ? RawSize : PaletteSize;
+    Size = (Size + ColdChunkAlignment - 1) & ~(ColdChunkAlignment - 1);
+
+    while (Store->Count >= Store->MaxCount)
+    {
+        DropOldestColdChunk(Store);
+    }
+    MakeRoomForColdChunk(Store, Size);
+
+    u32 Offset = Store->NextOffset;
+    cold_chunk_header *Header = (cold_chunk_header *) (Store->Ring + Offset);
+    Header->P = P;
+    Header->Size = (u16) Size;
+    Header->PaletteCount = IsRaw ? 0 : (u16) PaletteCount;
+
+    u16 *Data = (u16 *) (Header + 1);
+    if (IsRaw)
+    {
+        CopyChunkTiles(Data, Tiles);
+    }
+    else
+    {
+        for (u32 EntryI = 0;
+             EntryI < PaletteCount;
+             ++EntryI)
+        {
+            Data[EntryI] = Palette[EntryI];
+        }
+
+        u8 *Packed = (u8 *) (Data + PaletteCount);
+        u32 PackedSize = GetColdChunkPackedSize(BitsPerTile);
+        for (u32 ByteI = 0;
+             ByteI < PackedSize;
+             ++ByteI)
+        {
+            Packed[ByteI] = 0;
+        }
+        for (u32 TileI = 0;
+             TileI < ChunkTileCount;
+             ++TileI)
+        {
+            u32 Bit = TileI * BitsPerTile;
+            u32 Shifted = (u32) Indices[TileI] << (Bit & 7);
+            Packed[Bit >> 3] |= (u8) Shifted;
+            Packed[(Bit >> 3) + 1] |= (u8) (Shifted >> 8);
+        }
+    }
+
+    Store->NextOffset += Size;
+    Store->UsedBytes += Size;
+    Store->LiveBytes += Size;
+
+    u32 Slot = FindColdChunkSlot(Store, P);
+    Assert(!Store->Index[Slot].OffsetPlusOne);
+    Store->Index[Slot].P = P;
+    Store->Index[Slot].OffsetPlusOne = Offset + 1;
+    Store->Count++;
+}
+
+// NOTE: Main thread only. Unpacks the chunk into Tiles and forgets it, false when it isn't there.
+b32
+TakeColdChunk(cold_chunk_store *Store, vec3i P, u16 *Tiles)
+{
+    u32 Slot = FindColdChunkSlot(Store, P);
+    u32 OffsetPlusOne = Store->Index[Slot].OffsetPlusOne;
+    if (!OffsetPlusOne)
+    {
+        Store->MissCount++;
+        return false;
+    }
+
+    cold_chunk_header *Header = (cold_chunk_header *) (Store->Ring + OffsetPlusOne - 1);
+    Assert(Vec3IAreEqual(Header->P, P));
+    u16 *Data = (u16 *) (Header + 1);
+    if (!Header->PaletteCount)
+    {
+        CopyChunkTiles(Tiles, Data);
+    }
+    else
+    {
+        u32 BitsPerTile = GetColdChunkBitsPerTile(Header->PaletteCount);
+        u32 IndexMask = (1u << BitsPerTile) - 1;
+        u8 *Packed = (u8 *) (Data + Header->PaletteCount);
+        for (u32 TileI = 0;
+             TileI < ChunkTileCount;
+             ++TileI)
+        {
+            u32 Bit = TileI * BitsPerTile;
+            u32 Index = 0;
+            if (BitsPerTile)
+            {
+                u32 TwoBytes = Packed[Bit >> 3] | ((u32) Packed[(Bit >> 3) + 1] << 8);
+                Index = (TwoBytes >> (Bit & 7)) & IndexMask;
+            }
+            Tiles[TileI] = Data[Index];
+        }
+    }
+
+    RemoveColdChunkIndexEntry(Store, Slot);
+    Store->LiveBytes -= Header->Size;
+    Store->HitCount++;
+
+    return true;
+}
+
+//
+// NOTE: Chunk store
+//
+
+void
+InitChunkStore(chunk_store *Store, memory_arena *Arena, u32 MaxResidentCount, i32 KeepRadius)
+{
+    Store->Arena = Arena;
+    Store->MaxResidentCount = MaxResidentCount;
+    Store->KeepRadius = KeepRadius;
+
+    // NOTE: Never has to grow while under budget
+    u32 TableCapacity = 64;
+    while (TableCapacity * ChunkTableMaxLoadNumerator < 2 * MaxResidentCount * ChunkTableMaxLoadDenominator)
+    {
+        TableCapacity *= 2;
+    }
+    InitChunkTable(&Store->Table, Arena, TableCapacity);
+}
+
+internal void
+UnlinkChunkLru(chunk_store *Store, chunk *Chunk)
+{
+    if (Chunk->LruPrev)
+    {
+        Chunk->LruPrev->LruNext = Chunk->LruNext;
+    }
+    else
+    {
+        Store->MostRecentlyUsed = Chunk->LruNext;
+    }
+
+    if (Chunk->LruNext)
+    {
+        Chunk->LruNext->LruPrev = Chunk->LruPrev;
+    }
+    else
+    {
+        Store->LeastRecentlyUsed = Chunk->LruPrev;
+    }
+
+    Chunk->LruPrev = 0;
+    Chunk->LruNext = 0;
+}
+
+internal void
+LinkChunkLruFront(chunk_store *Store, chunk *Chunk)
+{
+    Chunk->LruPrev = 0;
+    Chunk->LruNext = Store->MostRecentlyUsed;
+    if (Store->MostRecentlyUsed)
+    {
+        Store->MostRecentlyUsed->LruPrev = Chunk;
+    }
+    else
+    {
+        Store->LeastRecentlyUsed = Chunk;
+    }
+    Store->MostRecentlyUsed = Chunk;
+}
+
+inline u32
+GetChunkNeighbourIndex(i32 DeltaX, i32 DeltaY)
+{
+    Assert(DeltaX >= -1 && DeltaX <= 1 && DeltaY >= -1 && DeltaY <= 1 && (DeltaX || DeltaY));
+    u32 Result = (u32) ((DeltaY + 1) * 3 + (DeltaX + 1));
+    if (Result > 4)
+    {
+        Result--;
+    }
+    return Result;
+}
+
+internal void
+LinkChunkNeighbours(chunk_store *Store, chunk *Chunk)
+{
+    for (i32 DeltaY = -1;
+         DeltaY <= 1;
+         ++DeltaY)
+    {
+        for (i32 DeltaX = -1;
+             DeltaX <= 1;
+             ++DeltaX)
+        {
+            if (DeltaX || DeltaY)
+            {
+                u32 NeighbourI = GetChunkNeighbourIndex(DeltaX, DeltaY);
+                chunk *Neighbour = GetChunk(&Store->Table, Chunk->P + Vec3I(DeltaX, DeltaY, 0));
+                Chunk->Neighbours[NeighbourI] = Neighbour;
+                if (Neighbour)
+                {
+                    Neighbour->Neighbours[ChunkNeighbourCount - 1 - NeighbourI] = Chunk;
+                }
+            }
+        }
+    }
+}
+
+internal void
+UnlinkChunkNeighbours(chunk *Chunk)
+{
+    for (u32 NeighbourI = 0;
+         NeighbourI < ChunkNeighbourCount;
+         ++NeighbourI)
+    {
+        chunk *Neighbour = Chunk->Neighbours[NeighbourI];
+        if (Neighbour)
+        {
+            Assert(Neighbour->Neighbours[ChunkNeighbourCount - 1 - NeighbourI] == Chunk);
+            Neighbour->Neighbours[ChunkNeighbourCount - 1 - NeighbourI] = 0;
+            Chunk->Neighbours[NeighbourI] = 0;
+        }
+    }
+}
+
+// NOTE: Looks the chunk up and marks it as used this frame, 0 when it isn't loaded
+chunk *
+UseChunk(chunk_store *Store, vec3i P)
+{
+    chunk *Result = GetChunk(&Store->Table, P);
+    if (Result && Result->LastUsedFrame != Store->Frame)
+    {
+        Result->LastUsedFrame = Store->Frame;
+        UnlinkChunkLru(Store, Result);
+        LinkChunkLruFront(Store, Result);
+    }
+    return Result;
+}
+
+// NOTE: A recycled chunk if there is one. It starts out ChunkState_Generating, the tiles are left for the caller to
+// fill in.
+chunk *
+AllocateChunk(chunk_store *Store, vec3i P)
+{
+    Assert(!GetChunk(&Store->Table, P));
+
+    chunk *Chunk = Store->FreeList;
+    if (Chunk)
+    {
+        Store->FreeList = Chunk->LruNext;
+        Store->FreeCount--;
+    }
+    else
+    {
+        Chunk = MemoryArena_PushStruct(Store->Arena, chunk);
+    }
+
+    Chunk->P = P;
+    Chunk->State = ChunkState_Generating;
+    Chunk->IsSaved = false;
+    Chunk->LastUsedFrame = Store->Frame;
+    LinkChunkLruFront(Store, Chunk);
+    InsertChunk(&Store->Table, P, Chunk);
+    LinkChunkNeighbours(Store, Chunk);
+    Store->ResidentCount++;
+
+    return Chunk;
+}
+
+inline i32
+GetChunkDistance(vec3i A, vec3i B)
+{
+    vec3i Delta = A - B;
+    i32 DistanceX = (Delta.X < 0) ? -Delta.X : Delta.X;
+    i32 DistanceY = (Delta.Y < 0) ? -Delta.Y : Delta.Y;
+    i32 DistanceZ = (Delta.Z < 0) ? -Delta.Z : Delta.Z;
+
+    i32 Result = Max(Max(DistanceX, DistanceY), DistanceZ);
+    return Result;
+}
+
+// NOTE: Saves every chunk that isn't, and waits until it's on disk
+void
+SaveAllChunks(chunk_store *Store)
+{
+    if (Store->Regions)
+    {
+        for (chunk *Chunk = Store->MostRecentlyUsed;
+             Chunk;
+             Chunk = Chunk->LruNext)
+        {
+            if (Chunk->State == ChunkState_Ready && !Chunk->IsSaved)
+            {
+                while (!SaveChunk(Store->Regions, Chunk->P, Chunk->Tiles))
+                {
+                    FlushRegionWrites(Store->Regions);
+                }
+                Chunk->IsSaved = true;
+            }
+        }
+        FlushRegionWrites(Store->Regions);
+    }
+}
+
+// NOTE: Once per frame, after everything that needs chunks this frame has used them. Chunks used this frame are never
+// evicted, even when they are outside KeepRadius, and neither are the ones still being generated.
+void
+EvictChunks(chunk_store *Store, vec3i CameraChunkP)
+{
+    chunk *Chunk = Store->LeastRecentlyUsed;
+    while (Chunk && Store->ResidentCount > Store->MaxResidentCount &&
+           Chunk->LastUsedFrame != Store->Frame)
+    {
+        chunk *MoreRecent = Chunk->LruPrev;
+        // NOTE: Chunks that need saving stay until there's room in the pending batch
+        if (Chunk->State == ChunkState_Ready && GetChunkDistance(Chunk->P, CameraChunkP) > Store->KeepRadius &&
+            (Chunk->IsSaved || !Store->Regions || SaveChunk(Store->Regions, Chunk->P, Chunk->Tiles)))
+        {
+            chunk *Removed = RemoveChunk(&Store->Table, Chunk->P);
+            Assert(Removed == Chunk);
+            UnlinkChunkLru(Store, Chunk);
+            UnlinkChunkNeighbours(Chunk);
+            if (Store->Cold)
+            {
+                AddColdChunk(Store->Cold, Chunk->P, Chunk->Tiles);
+            }
+
+            Chunk->LruNext = Store->FreeList;
+            Store->FreeList = Chunk;
+            Store->FreeCount++;
+            Store->ResidentCount--;
+            Store->EvictedCount++;
+        }
+        Chunk = MoreRecent;
+    }
+
+    Store->Frame++;
+}
+
+tile_cursor
+MakeTileCursor(chunk_store *Store, vec3i ChunkDim, vec3i TileP)
+{
+    tile_cursor Result = {};
+    Result.Store = Store;
+    Result.ChunkDim = ChunkDim;
+    Result.TileP = TileP;
+    Result.ChunkP = GetChunkPFromTileP(TileP, ChunkDim);
+    Result.Chunk = GetChunk(&Store->Table, Result.ChunkP);
+
+    vec3i ChunkTileP = TileP - GetLeftmostTilePFromChunkP(Result.ChunkP, ChunkDim);
+    Result.X = ChunkTileP.X;
+    Result.Y = ChunkTileP.Y;
+
+    return Result;
+}
+
+// NOTE: Moves within the level. Leaving the chunk by up to one chunk in each direction follows a neighbour link, only
+// moving further, or moving on from a chunk that isn't resident, looks the chunk up.
+void
+MoveTileCursor(tile_cursor *Cursor, i32 DeltaX, i32 DeltaY)
+{
+    vec3i ChunkDim = Cursor->ChunkDim;
+    i32 X = Cursor->X + DeltaX;
+    i32 Y = Cursor->Y + DeltaY;
+    Cursor->TileP.X += DeltaX;
+    Cursor->TileP.Y += DeltaY;
+
+    if (X < 0 || X >= ChunkDim.X || Y < 0 || Y >= ChunkDim.Y)
+    {
+        i32 ChunkDeltaX = GetChunkFromTile(X, ChunkDim.X);
+        i32 ChunkDeltaY = GetChunkFromTile(Y, ChunkDim.Y);
+        Cursor->ChunkP.X += ChunkDeltaX;
+        Cursor->ChunkP.Y += ChunkDeltaY;
+        X -= ChunkDeltaX * ChunkDim.X;
+        Y -= ChunkDeltaY * ChunkDim.Y;
+
+        if (Cursor->Chunk && ChunkDeltaX >= -1 && ChunkDeltaX <= 1 && ChunkDeltaY >= -1 && ChunkDeltaY <= 1)
+        {
+            Cursor->Chunk = Cursor->Chunk->Neighbours[GetChunkNeighbourIndex(ChunkDeltaX, ChunkDeltaY)];
+        }
+        else
+        {
+            Cursor->Chunk = GetChunk(&Cursor->Store->Table, Cursor->ChunkP);
+        }
+    }
+
+    Cursor->X = X;
+    Cursor->Y = Y;
+}
+
+// NOTE: 0 when the chunk isn't resident, or is still being generated
+inline u16 *
+GetTileAtCursor(tile_cursor *Cursor)
+{
+    u16 *Result = 0;
+    chunk *Chunk = Cursor->Chunk;
+    if (Chunk && Chunk->State == ChunkState_Ready)
+    {
+        Result = Chunk->Tiles + Cursor->Y * Cursor->ChunkDim.X + Cursor->X;
+    }
+    return Result;
+}
+
+//
+// NOTE: World generation
+//
+
+void
+InitChunkGenerationQueue(chunk_generation_queue *Queue, world_generator *Generator, chunk_store *Store,
+                         platform_work_queue *WorkQueue)
+{
+    Queue->Generator = Generator;
+    Queue->Store = Store;
+    Queue->WorkQueue = WorkQueue;
+
+    for (u32 JobI = 0;
+         JobI < ChunkGenerationMaxJobCount;
+         ++JobI)
+    {
+        Queue->Jobs[JobI].Queue = Queue;
+        Queue->FreeJobs[Queue->FreeJobCount++] = Queue->Jobs + JobI;
+    }
+}
+
+internal void
+GenerateChunkJob(platform_work_queue *WorkQueue, void *Data)
+{
+    chunk_generation_job *Job = (chunk_generation_job *) Data;
+    chunk_generation_queue *Queue = Job->Queue;
+
+    f64 StartSeconds = Platform_GetSeconds();
+    GenerateChunkTiles(Queue->Generator, Job->Chunk->P, Job->Chunk->Tiles);
+    Job->Seconds = Platform_GetSeconds() - StartSeconds;
+
+    // NOTE: The tiles have to be visible before the job is
+    CompletePreviousWritesBeforeFutureWrites;
+    u32 Slot = AtomicAddU32(&Queue->CompletedWriteIndex, 1) % ChunkGenerationMaxJobCount;
+    Queue->Completed[Slot] = Job;
+}
+
+// NOTE: Takes the chunk from the cold store, or loads it when it was saved before, otherwise puts a placeholder chunk
+// in the store and adds it to the backlog. Returns false, and does nothing, when the backlog is full.
+b32
+RequestChunk(chunk_generation_queue *Queue, vec3i P)
+{
+    chunk_store *Store = Queue->Store;
+    if (Queue->BacklogCount == ChunkGenerationMaxBacklogCount)
+    {
+        return false;
+    }
+
+    chunk *Chunk = AllocateChunk(Store, P);
+    if ((Store->Cold && TakeColdChunk(Store->Cold, P, Chunk->Tiles)) ||
+        (Store->Regions && LoadChunk(Store->Regions, P, Chunk->Tiles)))
+    {
+        Chunk->State = ChunkState_Ready;
+        Chunk->IsSaved = true;
+    }
+    else
+    {
+        Chunk->State = ChunkState_Generating;
+        Queue->Backlog[Queue->BacklogCount++] = Chunk;
+    }
+
+    return true;
+}
+
+// NOTE: Main thread only, once the generator is done with the chunk
+internal void
+FinishGeneratedChunk(chunk_generation_queue *Queue, chunk *Chunk)
+{
+    // NOTE: A store that keeps whole chunks doesn't have this one yet. One that keeps edits does, once they're on top.
+    region_store *Regions = Queue->Store->Regions;
+    if (Regions && Regions->Storage == RegionStorage_Edits)
+    {
+        ApplyChunkEdits(Regions, Chunk->P, Chunk->Tiles);
+        Chunk->IsSaved = true;
+    }
+
+    Chunk->State = ChunkState_Ready;
+    Queue->GeneratedCount++;
+}
+
+internal void
+AddChunkGenerationTime(chunk_generation_queue *Queue, f64 Seconds)
+{
+    if (Queue->SecondsPerChunk == 0.0)
+    {
+        Queue->SecondsPerChunk = Seconds;
+    }
+    else
+    {
+        Queue->SecondsPerChunk += (Seconds - Queue->SecondsPerChunk) * 0.1;
+    }
+}
+
+// NOTE: Main thread only, once per frame before anything looks at the chunks
+void
+PublishGeneratedChunks(chunk_generation_queue *Queue)
+{
+    for (;;)
+    {
+        u32 Slot = Queue->CompletedReadIndex % ChunkGenerationMaxJobCount;
+        chunk_generation_job *Job = Queue->Completed[Slot];
+        if (!Job)
+        {
+            break;
+        }
+        CompletePreviousReadsBeforeFutureReads;
+
+        Queue->Completed[Slot] = 0;
+        Queue->CompletedReadIndex++;
+
+        FinishGeneratedChunk(Queue, Job->Chunk);
+        Job->Chunk = 0;
+        AddChunkGenerationTime(Queue, Job->Seconds);
+        Queue->FreeJobs[Queue->FreeJobCount++] = Job;
+        Queue->InFlightCount--;
+    }
+}
+
+inline i32
+GetChunkDistanceSq(vec3i A, vec3i B)
+{
+    vec3i Delta = A - B;
+    i32 Result = Delta.X * Delta.X + Delta.Y * Delta.Y + Delta.Z * Delta.Z;
+    return Result;
+}
+
+// NOTE: Insertion sort, the backlog is short and mostly still sorted from the last frame
+internal void
+SortChunkBacklog(chunk_generation_queue *Queue, vec3i CameraChunkP)
+{
+    for (u32 I = 1;
+         I < Queue->BacklogCount;
+         ++I)
+    {
+        chunk *Chunk = Queue->Backlog[I];
+        i32 DistanceSq = GetChunkDistanceSq(Chunk->P, CameraChunkP);
+
+        u32 J = I;
+        while (J > 0 && GetChunkDistanceSq(Queue->Backlog[J - 1]->P, CameraChunkP) < DistanceSq)
+        {
+            Queue->Backlog[J] = Queue->Backlog[J - 1];
+            --J;
+        }
+        Queue->Backlog[J] = Chunk;
+    }
+}
+
+// NOTE: Main thread only, once per frame after the chunks for the frame were requested. Hands the backlog to the
+// workers, or without them, generates rows until BudgetSeconds have passed. At least one row is generated every call,
+// so the backlog drains however small the budget.
+void
+UpdateChunkGeneration(chunk_generation_queue *Queue, vec3i CameraChunkP, f64 BudgetSeconds)
+{
+    SortChunkBacklog(Queue, CameraChunkP);
+
+    if (Queue->WorkQueue)
+    {
+        // NOTE: Left over from generating on the main thread, not worth a job of its own
+        if (Queue->PartialChunk)
+        {
+            chunk *Chunk = Queue->PartialChunk;
+            GenerateChunkRows(Queue->Generator, Chunk->P, Chunk->Tiles, &Queue->PartialRandom,
+                              Queue->PartialNextRow, Queue->Generator->ChunkDim.Y);
+            FinishGeneratedChunk(Queue, Chunk);
+            Queue->PartialChunk = 0;
+        }
+
+        while (Queue->BacklogCount && Queue->FreeJobCount)
+        {
+            chunk_generation_job *Job = Queue->FreeJobs[--Queue->FreeJobCount];
+            Job->Chunk = Queue->Backlog[--Queue->BacklogCount];
+            Queue->InFlightCount++;
+
+            Platform_AddWorkEntry(Queue->WorkQueue, GenerateChunkJob, Job);
+        }
+    }
+    else
+    {
+        world_generator *Generator = Queue->Generator;
+        f64 EndSeconds = Platform_GetSeconds() + BudgetSeconds;
+        do
+        {
+            if (!Queue->PartialChunk)
+            {
+                if (!Queue->BacklogCount)
+                {
+                    break;
+                }
+
+                Queue->PartialChunk = Queue->Backlog[--Queue->BacklogCount];
+                Queue->PartialNextRow = 0;
+                Queue->PartialStartSeconds = Platform_GetSeconds();
+                SeedChunkRandom(&Queue->PartialRandom, Queue->Generator->Seed, Queue->PartialChunk->P);
+            }
+
+            chunk *Chunk = Queue->PartialChunk;
+            GenerateChunkRows(Generator, Chunk->P, Chunk->Tiles, &Queue->PartialRandom,
+                              Queue->PartialNextRow, Queue->PartialNextRow + 1);
+            Queue->PartialNextRow++;
+
+            if (Queue->PartialNextRow == Generator->ChunkDim.Y)
+            {
+                FinishGeneratedChunk(Queue, Chunk);
+                Queue->PartialChunk = 0;
+                AddChunkGenerationTime(Queue, Platform_GetSeconds() - Queue->PartialStartSeconds);
+            }
+        } while (Platform_GetSeconds() < EndSeconds);
+    }
+}
+
+// NOTE: Chunks requested but not generated yet, including the ones on the workers
+inline u32
+GetChunkGenerationPendingCount(chunk_generation_queue *Queue)
+{
+    u32 Result = Queue->BacklogCount + Queue->InFlightCount + (Queue->PartialChunk ? 1 : 0);
+    return Result;
+}
+
+//
+// NOTE: Prefetching
+//
+
+// NOTE: Step is how far the player moved this frame, in tiles
+void
+UpdatePrefetchVelocity(chunk_prefetcher *Prefetcher, vec2 Step, f32 DeltaTime)
+{
+    if (DeltaTime > 0.0f)
+    {
+        f32 Blend = Min(DeltaTime / PrefetchVelocitySmoothingSeconds, 1.0f);
+        Prefetcher->Velocity += (Step / DeltaTime - Prefetcher->Velocity) * Blend;
+    }
+}
+
+// NOTE: How many chunks beyond the view the prefetch rect reaches along one axis, 0 when not moving along it.
+// EdgeChunkCount is how many chunks come into view at once when crossing a chunk boundary on that axis.
+internal i32
+GetPrefetchDepth(f32 Speed, f64 SecondsPerChunk, i32 EdgeChunkCount, i32 ChunkDim)
+{
+    i32 Result = 0;
+
+    if (Speed >= PrefetchMinSpeed)
+    {
+        f32 TilesWhileGenerating = Speed * (f32) SecondsPerChunk * EdgeChunkCount;
+        Result = (i32) CeilingF(TilesWhileGenerating / ChunkDim) + 1;
+        Result = Min(Result, PrefetchMaxDepth);
+    }
+
+    return Result;
+}
+
+// NOTE: The view rect grown towards where the player is going
+void
+GetPrefetchRect(chunk_prefetcher *Prefetcher, f64 SecondsPerChunk, vec3i ChunkDim, vec3i ViewMin, vec3i ViewMax,
+                vec3i *Out_PrefetchMin, vec3i *Out_PrefetchMax)
+{
+    vec3i PrefetchMin = ViewMin;
+    vec3i PrefetchMax = ViewMax;
+    vec2 Velocity = Prefetcher->Velocity;
+
+    i32 DepthX = GetPrefetchDepth((Velocity.X < 0.0f) ? -Velocity.X : Velocity.X, SecondsPerChunk,
+                                  ViewMax.Y - ViewMin.Y + 1, ChunkDim.X);
+    if (Velocity.X < 0.0f)
+    {
+        PrefetchMin.X -= DepthX;
+    }
+    else
+    {
+        PrefetchMax.X += DepthX;
+    }
+
+    i32 DepthY = GetPrefetchDepth((Velocity.Y < 0.0f) ? -Velocity.Y : Velocity.Y, SecondsPerChunk,
+                                  ViewMax.X - ViewMin.X + 1, ChunkDim.Y);
+    if (Velocity.Y < 0.0f)
+    {
+        PrefetchMin.Y -= DepthY;
+    }
+    else
+    {
+        PrefetchMax.Y += DepthY;
+    }
+
+    *Out_PrefetchMin = PrefetchMin;
+    *Out_PrefetchMax = PrefetchMax;
+}
+
+// NOTE: Counts the chunks that weren't in the view last time, and how many of them were ready. Has to be called
+// before the view's chunks are requested.
+void
+CountNewlyVisibleChunks(chunk_prefetcher *Prefetcher, chunk_table *Table, vec3i ViewMin, vec3i ViewMax)
+{
+    if (Prefetcher->HasLastView)
+    {
+        for (i32 ChunkY = ViewMin.Y;
+             ChunkY <= ViewMax.Y;
+             ++ChunkY)
+        {
+            for (i32 ChunkX = ViewMin.X;
+                 ChunkX <= ViewMax.X;
+                 ++ChunkX)
+            {
+                b32 WasVisible = (ChunkX >= Prefetcher->LastViewMin.X && ChunkX <= Prefetcher->LastViewMax.X &&
+                                  ChunkY >= Prefetcher->LastViewMin.Y && ChunkY <= Prefetcher->LastViewMax.Y &&
+                                  ViewMin.Z == Prefetcher->LastViewMin.Z);
+                if (!WasVisible)
+                {
+                    Prefetcher->NewlyVisibleCount++;
+
+                    chunk *Chunk = GetChunk(Table, Vec3I(ChunkX, ChunkY, ViewMin.Z));
+                    if (Chunk && Chunk->State == ChunkState_Ready)
+                    {
+                        Prefetcher->HitCount++;
+                    }
+                }
+            }
+        }
+    }
+
+    Prefetcher->HasLastView = true;
+    Prefetcher->LastViewMin = ViewMin;
+    Prefetcher->LastViewMax = ViewMax;
+}
+
+//
+// NOTE: World preview
+//
+
+// NOTE: FNV-1a
+inline u64
+HashWorldPreviewBytes(u64 Hash, void *Data, u32 Size)
+{
+    u8 *Bytes = (u8 *) Data;
+    for (u32 ByteI = 0;
+         ByteI < Size;
+         ++ByteI)
+    {
+        Hash ^= Bytes[ByteI];
+        Hash *= 1099511628211ull;
+    }
+    return Hash;
+}
+
+inline u64
+HashWorldPreviewLayer(u64 Hash, noise_layer *Layer)
+{
+    Hash = HashWorldPreviewBytes(Hash, &Layer->Period, sizeof(Layer->Period));
+    Hash = HashWorldPreviewBytes(Hash, &Layer->Lacunarity, sizeof(Layer->Lacunarity));
+    Hash = HashWorldPreviewBytes(Hash, &Layer->Gain, sizeof(Layer->Gain));
+    Hash = HashWorldPreviewBytes(Hash, &Layer->Octaves, sizeof(Layer->Octaves));
+    Hash = HashWorldPreviewBytes(Hash, &Layer->Spacing, sizeof(Layer->Spacing));
+    Hash = HashWorldPreviewBytes(Hash, &Layer->Seed, sizeof(Layer->Seed));
+    return Hash;
+}
+
+// NOTE: The generator has to be set up already, its noise layers are part of the key
+void
+InitWorldPreview(world_preview *Preview, world_generator *Generator, platform_work_queue *WorkQueue)
+{
+    Assert(WorldPreviewTileDim <= PerlinGridMaxWidth);
+
+    Preview->Generator = Generator;
+    Preview->WorkQueue = WorkQueue;
+    Preview->MinX = -WorldPreviewRadius;
+    Preview->MinY = -WorldPreviewRadius;
+
+    i32 Dim = 2 * WorldPreviewRadius + 1;
+    platform_image *Images[] = { &Preview->ContinentalImage, &Preview->TerrainImage, &Preview->MapImage };
+    for (u32 ImageI = 0;
+         ImageI < ArrayCount(Images);
+         ++ImageI)
+    {
+        *Images[ImageI] = {};
+        Images[ImageI]->Width = Dim;
+        Images[ImageI]->Height = Dim;
+        Images[ImageI]->Pitch = Dim * 4;
+    }
+    Preview->TileCountX = (u32) ((Dim + WorldPreviewTileDim - 1) / WorldPreviewTileDim);
+    Preview->TileCount = Preview->TileCountX * Preview->TileCountX;
+
+    u32 Version = WorldPreviewVersion;
+    u64 Hash = 14695981039346656037ull;
+    Hash = HashWorldPreviewBytes(Hash, &Version, sizeof(Version));
+    Hash = HashWorldPreviewBytes(Hash, &Preview->MinX, sizeof(Preview->MinX));
+    Hash = HashWorldPreviewBytes(Hash, &Preview->MinY, sizeof(Preview->MinY));
+    Hash = HashWorldPreviewBytes(Hash, &Dim, sizeof(Dim));
+    Hash = HashWorldPreviewLayer(Hash, &Generator->Continental);
+    Hash = HashWorldPreviewLayer(Hash, &Generator->Terrain);
+    Preview->Key = Hash;
+}
+
+// NOTE: What the image is saved as, without the timestamp, i.e. temp/<name>.bmp
+inline simple_string
+GetWorldPreviewName(world_preview *Preview, const char *Image)
+{
+    simple_string Result = SimpleStringF("preview_%s_%016llx", Image, (unsigned long long) Preview->Key);
+    return Result;
+}
+
+// NOTE: All three images are on disk, and none of them was cut short
+internal b32
+IsWorldPreviewSaved(world_preview *Preview)
+{
+    const char *Names[] = { "continental", "terrain", "map" };
+    b32 Result = true;
+    for (u32 ImageI = 0;
+         ImageI < ArrayCount(Names);
+         ++ImageI)
+    {
+        simple_string Path = SimpleStringF("temp/%s.bmp", GetWorldPreviewName(Preview, Names[ImageI]).D);
+        platform_mapped_file File = Platform_MapFile(Path.D);
+        if (!File.Data || File.Size < (u64) Preview->MapImage.Height * (u64) Preview->MapImage.Pitch)
+        {
+            Result = false;
+        }
+        Platform_UnmapFile(&File);
+    }
+    return Result;
+}
+
+internal void
+DrawWorldPreviewTile(world_preview *Preview, u32 TileIndex)
+{
+    world_generator *Generator = Preview->Generator;
+    i32 TileX = (i32) (TileIndex % Preview->TileCountX) * WorldPreviewTileDim;
+    i32 TileY = (i32) (TileIndex / Preview->TileCountX) * WorldPreviewTileDim;
+    i32 Width = Min(Preview->MapImage.Width - TileX, WorldPreviewTileDim);
+    i32 Height = Min(Preview->MapImage.Height - TileY, WorldPreviewTileDim);
+
+    f32 ContinentalSamples[WorldPreviewTileDim * WorldPreviewTileDim];
+    f32 TerrainSamples[WorldPreviewTileDim * WorldPreviewTileDim];
+    SampleNoiseLayer(&Generator->Continental, ContinentalSamples, Width, Height,
+                     Preview->MinX + TileX, Preview->MinY + TileY);
+    SampleNoiseLayer(&Generator->Terrain, TerrainSamples, Width, Height, Preview->MinX + TileX, Preview->MinY + TileY);
+
+    i32 Pitch = Preview->MapImage.Pitch;
+    for (i32 Y = 0;
+         Y < Height;
+         ++Y)
+    {
+        i32 RowOffset = (TileY + Y) * Pitch + TileX * 4;
+        u32 *ContinentalRow = (u32 *) ((u8 *) Preview->ContinentalImage.ImageData + RowOffset);
+        u32 *TerrainRow = (u32 *) ((u8 *) Preview->TerrainImage.ImageData + RowOffset);
+        u32 *MapRow = (u32 *) ((u8 *) Preview->MapImage.ImageData + RowOffset);
+        for (i32 X = 0;
+             X < Width;
+             ++X)
+        {
+            f32 ContinentalIntensity = PerlinNormalize(ContinentalSamples[Y * Width + X]);
+            f32 Intensity = PerlinNormalize(TerrainSamples[Y * Width + X]);
+
+            u32 ContinentalByte = (u32) (ContinentalIntensity * 255.0f);
+            ContinentalRow[X] = (ContinentalByte << 24 | ContinentalByte << 16 | ContinentalByte << 8 | 255);
+            u32 TerrainByte = (u32) (Intensity * 255.0f);
+            TerrainRow[X] = (TerrainByte << 24 | TerrainByte << 16 | TerrainByte << 8 | 255);
+
+            u16 Type = GetTerrainTileType(Generator, ContinentalIntensity, Intensity);
+            u32 Color = ((Type == Generator->WaterTileType) ? 0x0000FFFF :
+                         (Type == Generator->MountainTileType) ? 0xAAAAAAFF :
+                         0x00FF00FF);
+            if (Preview->MinX + TileX + X == 0 && Preview->MinY + TileY + Y == 0)
+            {
+                // NOTE: The origin
+                Color = 0x000000FF;
+            }
+            MapRow[X] = Color;
+        }
+    }
+
+    // NOTE: Everything drawn before the add, so whoever counts the last square sees all of them in the images
+    u32 CompletedCount = AtomicAddU32(&Preview->CompletedTileCount, 1) + 1;
+    if (CompletedCount == Preview->TileCount)
+    {
+        Platform_SaveRGBA_BMP(&Preview->ContinentalImage, GetWorldPreviewName(Preview, "continental").D, false);
+        Platform_SaveRGBA_BMP(&Preview->TerrainImage, GetWorldPreviewName(Preview, "terrain").D, false);
+        Platform_SaveRGBA_BMP(&Preview->MapImage, GetWorldPreviewName(Preview, "map").D, false);
+
+        CompletePreviousWritesBeforeFutureWrites;
+        Preview->IsDone = true;
+    }
+}
+
+internal void
+DrawWorldPreviewTileJob(platform_work_queue *WorkQueue, void *Data)
+{
+    world_preview *Preview = (world_preview *) Data;
+
+    DrawWorldPreviewTile(Preview, AtomicAddU32(&Preview->NextTileIndex, 1));
+}
+
+// NOTE: Main thread only. The images come out of Arena the first time. Returns false when the preview is on disk
+// already, or still being drawn.
+b32
+StartWorldPreview(world_preview *Preview, memory_arena *Arena)
+{
+    b32 Result = false;
+    if (!Preview->IsRunning && !IsWorldPreviewSaved(Preview))
+    {
+        platform_image *Images[] = { &Preview->ContinentalImage, &Preview->TerrainImage, &Preview->MapImage };
+        for (u32 ImageI = 0;
+             ImageI < ArrayCount(Images);
+             ++ImageI)
+        {
+            if (!Images[ImageI]->ImageData)
+            {
+                u32 PixelCount = (u32) (Images[ImageI]->Width * Images[ImageI]->Height);
+                Images[ImageI]->ImageData = (void *) MemoryArena_PushArray(Arena, PixelCount, u32);
+            }
+        }
+        Platform_CreateDirectory("temp");
+
+        Preview->IsRunning = true;
+        Preview->StartSeconds = Platform_GetSeconds();
+        Preview->QueuedTileCount = 0;
+        Preview->NextTileIndex = 0;
+        Preview->CompletedTileCount = 0;
+        Preview->IsDone = false;
+        Result = true;
+    }
+    return Result;
+}
+
+// NOTE: Main thread only, once per frame
+void
+UpdateWorldPreview(world_preview *Preview)
+{
+    if (Preview->IsRunning)
+    {
+        if (Preview->WorkQueue)
+        {
+            while (Preview->QueuedTileCount < Preview->TileCount &&
+                   Preview->QueuedTileCount - Preview->CompletedTileCount < WorldPreviewMaxJobCount)
+            {
+                Platform_AddWorkEntry(Preview->WorkQueue, DrawWorldPreviewTileJob, Preview);
+                Preview->QueuedTileCount++;
+            }
+        }
+        else if (Preview->QueuedTileCount < Preview->TileCount)
+        {
+            Preview->QueuedTileCount++;
+            DrawWorldPreviewTile(Preview, AtomicAddU32(&Preview->NextTileIndex, 1));
+        }
+
+        if (Preview->IsDone)
+        {
+            CompletePreviousReadsBeforeFutureReads;
+            Preview->IsRunning = false;
+            printf("World preview: %u squares in %.0fms, saved as temp/%s.bmp\n", Preview->TileCount,
+                   1000.0 * (Platform_GetSeconds() - Preview->StartSeconds), GetWorldPreviewName(Preview, "map").D);
+        }
+    }
+}
+
+#if SAVOUR_INTERNAL
+// NOTE: Lookup cost against the number of chunks loaded, for chunks that are there and ones that aren't, with a
+// linear scan over the same positions (what the chunk list used to do, minus the pointer chasing) for comparison
+void
+DEBUG_BenchmarkChunkTable(memory_arena *TransientArena)
+{
+    u32 MaxChunkCount = 65536;
+    u32 LookupCount = 1 << 20;
+    u32 ScanMaxChunkCount = 4096;
+
+    // NOTE: The table never looks inside, so every entry can point at the same one
+    chunk DummyChunk = {};
+
+    for (u32 ChunkCount = 64;
+         ChunkCount <= MaxChunkCount;
+         ChunkCount *= 4)
+    {
+        MemoryArena_Freeze(TransientArena);
+
+        chunk_table Table = {};
+        InitChunkTable(&Table, TransientArena, 64);
+
+        // NOTE: A square of loaded chunks around the origin, like after walking around for a while
+        i32 Side = 1;
+        while ((u32) (Side * Side) < ChunkCount)
+        {
+            ++Side;
+        }
+        vec3i *Positions = MemoryArena_PushArray(TransientArena, ChunkCount, vec3i);
+        for (u32 ChunkI = 0;
+             ChunkI < ChunkCount;
+             ++ChunkI)
+        {
+            Positions[ChunkI] = Vec3I((i32) ChunkI % Side - Side / 2, (i32) ChunkI / Side - Side / 2, 0);
+            InsertChunk(&Table, Positions[ChunkI], &DummyChunk);
+        }
+
+        u32 Found = 0;
+        f64 StartSeconds = Platform_GetSeconds();
+        for (u32 LookupI = 0;
+             LookupI < LookupCount;
+             ++LookupI)
+        {
+            Found += (GetChunk(&Table, Positions[(LookupI * 2654435761u) % ChunkCount]) != 0);
+        }
+        f64 HitSeconds = Platform_GetSeconds() - StartSeconds;
+        Assert(Found == LookupCount);
+
+        StartSeconds = Platform_GetSeconds();
+        for (u32 LookupI = 0;
+             LookupI < LookupCount;
+             ++LookupI)
+        {
+            vec3i P = Positions[(LookupI * 2654435761u) % ChunkCount];
+            P.Z = 1;
+            Found += (GetChunk(&Table, P) != 0);
+        }
+        f64 MissSeconds = Platform_GetSeconds() - StartSeconds;
+        Assert(Found == LookupCount);
+
+        f64 ScanSeconds = 0.0;
+        u32 ScanLookupCount = LookupCount / ChunkCount;
+        if (ChunkCount <= ScanMaxChunkCount)
+        {
+            StartSeconds = Platform_GetSeconds();
+            for (u32 LookupI = 0;
+                 LookupI < ScanLookupCount;
+                 ++LookupI)
+            {
+                vec3i P = Positions[(LookupI * 2654435761u) % ChunkCount];
+                for (u32 ChunkI = 0;
+                     ChunkI < ChunkCount;
+                     ++ChunkI)
+                {
+                    if (Vec3IAreEqual(Positions[ChunkI], P))
+                    {
+                        Found++;
+                        break;
+                    }
+                }
+            }
+            ScanSeconds = Platform_GetSeconds() - StartSeconds;
+            Assert(Found == LookupCount + ScanLookupCount);
+        }
+
+        // NOTE: Removing every other chunk has to leave the rest findable
+        for (u32 ChunkI = 0;
+             ChunkI < ChunkCount;
+             ChunkI += 2)
+        {
+            Assert(RemoveChunk(&Table, Positions[ChunkI]) == &DummyChunk);
+        }
+        for (u32 ChunkI = 0;
+             ChunkI < ChunkCount;
+             ++ChunkI)
+        {
+            Assert((GetChunk(&Table, Positions[ChunkI]) != 0) == (ChunkI % 2 == 1));
+        }
+
+        printf("Chunk table: %6u chunks, capacity %6u, hit %5.1fns, miss %5.1fns",
+               ChunkCount, Table.Capacity, 1e9 * HitSeconds / LookupCount, 1e9 * MissSeconds / LookupCount);
+        if (ChunkCount <= ScanMaxChunkCount)
+        {
+            printf(", linear scan %7.1fns", 1e9 * ScanSeconds / ScanLookupCount);
+        }
+        printf("\n");
+
+        MemoryArena_Unfreeze(TransientArena);
+    }
+}
+
+// NOTE: The terrain noise of a square of chunks, sampled tile by tile like the generator used to, with the grid
+// sampler on every tile, and with the layers as the generator samples them. How far the last two are from the first,
+// the exact grid has to be within PerlinGridEpsilon.
+void
+DEBUG_BenchmarkChunkNoise(world_generator *Generator, memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    i32 Side = 16;
+    i32 ChunkCount = Side * Side;
+    i32 SampleCount = 2 * ChunkCount * ChunkTileCount;
+    // NOTE: One per tile per octave of either layer
+    f64 OctaveSampleCount = (f64) (ChunkCount * ChunkTileCount) * (Generator->Continental.Octaves +
+                                                                  Generator->Terrain.Octaves);
+    vec3i ChunkDim = Generator->ChunkDim;
+    Assert(ChunkDim.X * ChunkDim.Y == ChunkTileCount);
+    vec3i FirstChunkP = Vec3I(-Side / 2, -Side / 2, 0);
+
+    noise_layer ExactLayers[2] = { Generator->Continental, Generator->Terrain };
+    ExactLayers[0].Spacing = 1;
+    ExactLayers[1].Spacing = 1;
+    noise_layer *Layers[3][2] =
+    {
+        { ExactLayers + 0, ExactLayers + 1 },
+        { ExactLayers + 0, ExactLayers + 1 },
+        { &Generator->Continental, &Generator->Terrain },
+    };
+    const char *Names[3] = { "scalar", "grid", "generator" };
+    f32 *Samples[3];
+    f64 Seconds[3];
+
+    for (u32 MethodI = 0;
+         MethodI < 3;
+         ++MethodI)
+    {
+        Samples[MethodI] = MemoryArena_PushArray(TransientArena, SampleCount, f32);
+
+        f64 StartSeconds = Platform_GetSeconds();
+        for (i32 ChunkI = 0;
+             ChunkI < ChunkCount;
+             ++ChunkI)
+        {
+            vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % Side, ChunkI / Side, 0);
+            i32 FirstX = ChunkP.X * ChunkDim.X;
+            i32 FirstY = ChunkP.Y * ChunkDim.Y;
+            for (u32 LayerI = 0;
+                 LayerI < 2;
+                 ++LayerI)
+            {
+                noise_layer *Layer = Layers[MethodI][LayerI];
+                f32 *ChunkSamples = Samples[MethodI] + (2 * ChunkI + LayerI) * ChunkTileCount;
+                if (MethodI == 0)
+                {
+                    for (i32 TileI = 0;
+                         TileI < ChunkTileCount;
+                         ++TileI)
+                    {
+                        i32 X = FirstX + TileI % ChunkDim.X;
+                        i32 Y = FirstY + TileI / ChunkDim.X;
+                        ChunkSamples[TileI] = PerlinSampleOctaves(&Layer->Noise, X / Layer->Period,
+                                                                  Y / Layer->Period, Layer->Lacunarity, Layer->Gain,
+                                                                  Layer->Octaves);
+                    }
+                }
+                else
+                {
+                    SampleNoiseLayer(Layer, ChunkSamples, ChunkDim.X, ChunkDim.Y, FirstX, FirstY);
+                }
+            }
+        }
+        Seconds[MethodI] = Platform_GetSeconds() - StartSeconds;
+
+        f32 MaxError = 0.0f;
+        for (i32 SampleI = 0;
+             SampleI < SampleCount;
+             ++SampleI)
+        {
+            MaxError = Max(MaxError, AbsF(Samples[0][SampleI] - Samples[MethodI][SampleI]));
+        }
+
+        printf("Chunk noise, %-9s: %d chunks, %8.0f chunks/s (%4.1fx), %5.2f ns/sample, max error %g",
+               Names[MethodI], ChunkCount, ChunkCount / Seconds[MethodI], Seconds[0] / Seconds[MethodI],
+               1e9 * Seconds[MethodI] / OctaveSampleCount, MaxError);
+        if (MethodI == 2)
+        {
+            printf(", continental every %d tiles", Generator->Continental.Spacing);
+        }
+        printf("\n");
+        Assert(MethodI != 1 || MaxError <= PerlinGridEpsilon);
+    }
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+
+// NOTE: A random walk over a square of resident chunks, one tile in any of 8 directions per step, bouncing off the
+// edges. Every step reads the tile, once looking its chunk up and once through a tile cursor.
+void
+DEBUG_BenchmarkTileCursor(memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    i32 Side = 32;
+    u32 StepCount = 1 << 22;
+    vec3i ChunkDim = Vec3I(16, 16, 1);
+    Assert(ChunkDim.X * ChunkDim.Y == ChunkTileCount);
+
+    chunk_store *Store = MemoryArena_PushStruct(TransientArena, chunk_store);
+    *Store = {};
+    InitChunkStore(Store, TransientArena, (u32) (Side * Side), 0);
+    for (i32 ChunkI = 0;
+         ChunkI < Side * Side;
+         ++ChunkI)
+    {
+        chunk *Chunk = AllocateChunk(Store, Vec3I(ChunkI % Side, ChunkI / Side, 0));
+        for (u32 TileI = 0;
+             TileI < ChunkTileCount;
+             ++TileI)
+        {
+            Chunk->Tiles[TileI] = (u16) (ChunkI * 31 + TileI);
+        }
+        Chunk->State = ChunkState_Ready;
+    }
+
+    vec2i Directions[] =
+    {
+        Vec2I(-1, -1), Vec2I(0, -1), Vec2I(1, -1), Vec2I(-1, 0), Vec2I(1, 0), Vec2I(-1, 1), Vec2I(0, 1), Vec2I(1, 1),
+    };
+    u8 *Steps = MemoryArena_PushArray(TransientArena, StepCount, u8);
+    random_state Random;
+    SeedRandom(&Random, 1234);
+    for (u32 StepI = 0;
+         StepI < StepCount;
+         ++StepI)
+    {
+        Steps[StepI] = (u8) (GetRandomU32(&Random) % ArrayCount(Directions));
+    }
+
+    i32 TileSide = Side * ChunkDim.X;
+    vec3i StartP = Vec3I(TileSide / 2, TileSide / 2, 0);
+
+    u64 LookupSum = 0;
+    vec3i P = StartP;
+    f64 StartSeconds = Platform_GetSeconds();
+    for (u32 StepI = 0;
+         StepI < StepCount;
+         ++StepI)
+    {
+        vec2i Step = Directions[Steps[StepI]];
+        Step.X = (P.X + Step.X < 0 || P.X + Step.X >= TileSide) ? -Step.X : Step.X;
+        Step.Y = (P.Y + Step.Y < 0 || P.Y + Step.Y >= TileSide) ? -Step.Y : Step.Y;
+        P.X += Step.X;
+        P.Y += Step.Y;
+
+        vec3i ChunkP = GetChunkPFromTileP(P, ChunkDim);
+        chunk *Chunk = GetChunk(&Store->Table, ChunkP);
+        vec3i ChunkTileP = P - GetLeftmostTilePFromChunkP(ChunkP, ChunkDim);
+        LookupSum += Chunk->Tiles[ChunkTileP.Y * ChunkDim.X + ChunkTileP.X];
+    }
+    f64 LookupSeconds = Platform_GetSeconds() - StartSeconds;
+
+    u64 CursorSum = 0;
+    tile_cursor Cursor = MakeTileCursor(Store, ChunkDim, StartP);
+    StartSeconds = Platform_GetSeconds();
+    for (u32 StepI = 0;
+         StepI < StepCount;
+         ++StepI)
+    {
+        vec2i Step = Directions[Steps[StepI]];
+        Step.X = (Cursor.TileP.X + Step.X < 0 || Cursor.TileP.X + Step.X >= TileSide) ? -Step.X : Step.X;
+        Step.Y = (Cursor.TileP.Y + Step.Y < 0 || Cursor.TileP.Y + Step.Y >= TileSide) ? -Step.Y : Step.Y;
+        MoveTileCursor(&Cursor, Step.X, Step.Y);
+
+        CursorSum += *GetTileAtCursor(&Cursor);
+    }
+    f64 CursorSeconds = Platform_GetSeconds() - StartSeconds;
+
+    printf("Tile cursor: %u steps over %d chunks, lookup %5.2fns, cursor %5.2fns (%.1fx)\n", StepCount, Side * Side,
+           1e9 * LookupSeconds / StepCount, 1e9 * CursorSeconds / StepCount, LookupSeconds / CursorSeconds);
+    Assert(LookupSum == CursorSum);
+    Assert(Vec3IAreEqual(P, Cursor.TileP));
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+
+// NOTE: Chunks per second from the noise against from a region file, and how big the file is, with each storage. A
+// few tiles of every 16th chunk are changed, like the player would. The regions sit far away in their own
+// directories, the first run writes them and later ones only load. Loads start from a fresh mapping, so every page is
+// faulted in, though most likely from the OS file cache rather than the disk.
+void
+DEBUG_BenchmarkRegionFiles(world_generator *Generator, memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    vec3i FirstChunkP = Vec3I(1000 * RegionDim, 1000 * RegionDim, 0);
+    vec3i RegionP = GetRegionPFromChunkP(FirstChunkP);
+    u32 EditedChunkStride = 16;
+    u16 *Expected = MemoryArena_PushArray(TransientArena, RegionChunkCount * ChunkTileCount, u16);
+    u16 *Loaded = MemoryArena_PushArray(TransientArena, RegionChunkCount * ChunkTileCount, u16);
+
+    f64 StartSeconds = Platform_GetSeconds();
+    for (u32 ChunkI = 0;
+         ChunkI < RegionChunkCount;
+         ++ChunkI)
+    {
+        vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % RegionDim, ChunkI / RegionDim, 0);
+        GenerateChunkTiles(Generator, ChunkP, Expected + ChunkI * ChunkTileCount);
+    }
+    f64 GenerateSeconds = Platform_GetSeconds() - StartSeconds;
+    printf("Region files: %u chunks, generate %8.0f chunks/s\n", RegionChunkCount, RegionChunkCount / GenerateSeconds);
+
+    for (u32 ChunkI = 0;
+         ChunkI < RegionChunkCount;
+         ChunkI += EditedChunkStride)
+    {
+        for (u32 EditI = 0;
+             EditI < 4;
+             ++EditI)
+        {
+            // NOTE: The other variant of the same tile type, always a valid tile
+            Expected[ChunkI * ChunkTileCount + EditI * 37] ^= 1;
+        }
+    }
+
+    region_storage Storages[] = { RegionStorage_Tiles, RegionStorage_Edits };
+    const char *StorageNames[] = { "tiles", "edits" };
+    const char *Directories[] = { "temp/region_benchmark_tiles", "temp/region_benchmark_edits" };
+    for (u32 StorageI = 0;
+         StorageI < ArrayCount(Storages);
+         ++StorageI)
+    {
+        region_store *Store = MemoryArena_PushStruct(TransientArena, region_store);
+        *Store = {};
+        InitRegionStore(Store, Directories[StorageI], Storages[StorageI], Generator, 0);
+
+        // NOTE: Saved like the game would, everything with tiles, only what was changed with edits
+        u32 SaveCount = 0;
+        StartSeconds = Platform_GetSeconds();
+        for (u32 ChunkI = 0;
+             ChunkI < RegionChunkCount;
+             ++ChunkI)
+        {
+            vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % RegionDim, ChunkI / RegionDim, 0);
+            u64 RecordSize;
+            b32 NeedsSaving = (Store->Storage == RegionStorage_Tiles || ChunkI % EditedChunkStride == 0);
+            if (NeedsSaving && !GetChunkRecord(Store, ChunkP, &RecordSize))
+            {
+                while (!SaveChunk(Store, ChunkP, Expected + ChunkI * ChunkTileCount))
+                {
+                    FlushRegionWrites(Store);
+                }
+                SaveCount++;
+            }
+        }
+        FlushRegionWrites(Store);
+        f64 SaveSeconds = Platform_GetSeconds() - StartSeconds;
+
+        UnmapRegion(Store, RegionP);
+        u64 FileSize = GetMappedRegion(Store, RegionP)->File.Size;
+        UnmapRegion(Store, RegionP);
+
+        StartSeconds = Platform_GetSeconds();
+        for (u32 ChunkI = 0;
+             ChunkI < RegionChunkCount;
+             ++ChunkI)
+        {
+            vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % RegionDim, ChunkI / RegionDim, 0);
+            u16 *Tiles = Loaded + ChunkI * ChunkTileCount;
+            if (!LoadChunk(Store, ChunkP, Tiles))
+            {
+                GenerateChunkTiles(Generator, ChunkP, Tiles);
+                ApplyChunkEdits(Store, ChunkP, Tiles);
+            }
+        }
+        f64 LoadSeconds = Platform_GetSeconds() - StartSeconds;
+
+        u32 MismatchCount = 0;
+        for (u32 TileI = 0;
+             TileI < RegionChunkCount * ChunkTileCount;
+             ++TileI)
+        {
+            MismatchCount += (Expected[TileI] != Loaded[TileI]);
+        }
+
+        printf("Region files, %s: load %8.0f chunks/s (%5.1fx generating), %6llu bytes on disk",
+               StorageNames[StorageI], RegionChunkCount / LoadSeconds, GenerateSeconds / LoadSeconds,
+               (unsigned long long) FileSize);
+        if (SaveCount)
+        {
+            printf(", saved %u first in %.1fms", SaveCount, 1000.0 * SaveSeconds);
+        }
+        printf("\n");
+        Assert(MismatchCount == 0);
+
+        UnmapRegion(Store, RegionP);
+    }
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+
+// NOTE: Time to put a generated chunk into the cold store and take it out again, and how small it gets, with a budget
+// big enough that nothing is dropped
+void
+DEBUG_BenchmarkColdChunks(world_generator *Generator, memory_arena *TransientArena)
+{
+    MemoryArena_Freeze(TransientArena);
+
+    u32 ChunkCount = RegionChunkCount;
+    vec3i FirstChunkP = Vec3I(-(i32) RegionDim / 2, -(i32) RegionDim / 2, 0);
+    u16 *Expected = MemoryArena_PushArray(TransientArena, ChunkCount * ChunkTileCount, u16);
+    u16 *Taken = MemoryArena_PushArray(TransientArena, ChunkCount * ChunkTileCount, u16);
+    for (u32 ChunkI = 0;
+         ChunkI < ChunkCount;
+         ++ChunkI)
+    {
+        vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % RegionDim, ChunkI / RegionDim, 0);
+        GenerateChunkTiles(Generator, ChunkP, Expected + ChunkI * ChunkTileCount);
+    }
+
+    cold_chunk_store *Store = MemoryArena_PushStruct(TransientArena, cold_chunk_store);
+    *Store = {};
+    u32 BudgetBytes = ChunkCount * (sizeof(cold_chunk_header) + ChunkTileCount * sizeof(u16) + ColdChunkAlignment);
+    InitColdChunkStore(Store, TransientArena, BudgetBytes);
+
+    f64 StartSeconds = Platform_GetSeconds();
+    for (u32 ChunkI = 0;
+         ChunkI < ChunkCount;
+         ++ChunkI)
+    {
+        vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % RegionDim, ChunkI / RegionDim, 0);
+        AddColdChunk(Store, ChunkP, Expected + ChunkI * ChunkTileCount);
+    }
+    f64 AddSeconds = Platform_GetSeconds() - StartSeconds;
+    u32 LiveBytes = Store->LiveBytes;
+
+    StartSeconds = Platform_GetSeconds();
+    for (u32 ChunkI = 0;
+         ChunkI < ChunkCount;
+         ++ChunkI)
+    {
+        vec3i ChunkP = FirstChunkP + Vec3I(ChunkI % RegionDim, ChunkI / RegionDim, 0);
+        b32 WasThere = TakeColdChunk(Store, ChunkP, Taken + ChunkI * ChunkTileCount);
+        Assert(WasThere);
+    }
+    f64 TakeSeconds = Platform_GetSeconds() - StartSeconds;
+
+    u32 MismatchCount = 0;
+    for (u32 TileI = 0;
+         TileI < ChunkCount * ChunkTileCount;
+         ++TileI)
+    {
+        MismatchCount += (Expected[TileI] != Taken[TileI]);
+    }
+
+    printf("Cold chunks: %u chunks, add %6.2fus, take %6.2fus, %7u bytes (%.1fx), %u dropped\n", ChunkCount,
+           1e6 * AddSeconds / ChunkCount, 1e6 * TakeSeconds / ChunkCount, LiveBytes,
+           (f64) (ChunkCount * ChunkTileCount * sizeof(u16)) / LiveBytes, Store->DroppedCount);
+    Assert(MismatchCount == 0);
+    Assert(Store->DroppedCount == 0);
+
+    MemoryArena_Unfreeze(TransientArena);
+}
+#endif
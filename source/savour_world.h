@@ -0,0 +1,424 @@
+#ifndef SAVOUR_WORLD_H
+#define SAVOUR_WORLD_H
+
+#include "and_common.h"
+#include "and_linmath.h"
+#include "and_random.h"
+
+#include "savour_platform.h"
+
+// NOTE: Everything tiles of one kind have in common. Chunks only store a tile id per tile, which is the index of its
+// type shifted up by one with a variant bit below, picking one of the type's two glyphs.
+#define TileTypeMaxCount 256
+
+struct tile_type
+{
+    u8 Glyphs[2];
+    // NOTE: Index into the palette
+    u16 ColorPair;
+    b32 IsBlocking;
+    b32 IsOpaque;
+};
+
+struct tile_type_table
+{
+    u32 Count;
+    tile_type Types[TileTypeMaxCount];
+};
+
+// NOTE: Chunk 16x16x1, tiles row by row
+#define ChunkTileCount 256
+// NOTE: The chunks around a chunk on its own level, row by row from -X -Y, skipping the chunk itself
+#define ChunkNeighbourCount 8
+
+enum chunk_state
+{
+    // NOTE: A worker owns the tiles until the chunk is published
+    ChunkState_Generating,
+    ChunkState_Ready,
+};
+
+struct chunk
+{
+    vec3i P;
+    chunk_state State;
+    // NOTE: The tiles are the same as in the region file, so the chunk can be dropped without saving it
+    b32 IsSaved;
+
+    // NOTE: Resident chunks are kept in a list, LruPrev pointing to the more recently used neighbour. Free chunks are
+    // chained through LruNext.
+    u64 LastUsedFrame;
+    chunk *LruPrev;
+    chunk *LruNext;
+
+    // NOTE: 0 for the neighbours that aren't resident. Linked when a chunk is put in the store and unlinked when it's
+    // evicted, from both sides, so a link is never stale. The opposite of neighbour I is ChunkNeighbourCount - 1 - I.
+    chunk *Neighbours[ChunkNeighbourCount];
+
+    u16 Tiles[ChunkTileCount];
+};
+
+// NOTE: Open addressing with linear probing, keyed on the chunk position. The key is stored next to the pointer so a
+// probe never has to touch the chunk itself. Removing shifts the following entries back, so there are no tombstones
+// and lookups stay short no matter how many chunks came and went. Capacity is a power of two. Growing takes a new
+// entry array from the arena and leaves the old one behind, which is at most as big as all the live ones together.
+#define ChunkTableMaxLoadNumerator 3
+#define ChunkTableMaxLoadDenominator 4
+
+struct chunk_table_entry
+{
+    vec3i P;
+    // NOTE: 0 when the entry is empty
+    chunk *Chunk;
+};
+
+struct chunk_table
+{
+    memory_arena *Arena;
+    u32 Capacity;
+    u32 Count;
+    chunk_table_entry *Entries;
+};
+
+// NOTE: One of the fBm layers terrain is made of, sampled every Spacing tiles and interpolated in between (see
+// PerlinSampleOctavesCoarseGrid), 1 for every tile
+struct noise_layer
+{
+    f32 Period;
+    f32 Lacunarity;
+    f32 Gain;
+    u32 Octaves;
+    i32 Spacing;
+    // NOTE: What Noise was shuffled from
+    u64 Seed;
+    perlin_noise Noise;
+};
+
+// NOTE: Saved in region files, for when the generator makes different tiles from the same seed. Edits stored against
+// the old terrain would land on the wrong tiles.
+#define WorldGeneratorVersion 3
+
+// NOTE: What the terrain generator needs, set once at startup and only read after that, from any thread
+struct world_generator
+{
+    // NOTE: Where every chunk's random stream starts, for what the noise doesn't decide
+    u64 Seed;
+    vec3i ChunkDim;
+    u16 GrassTileType;
+    u16 WaterTileType;
+    u16 MountainTileType;
+
+    noise_layer Continental;
+    noise_layer Terrain;
+};
+
+// NOTE: Chunks saved to disk, RegionDim x RegionDim chunks of one level to a file. A region file starts with a header
+// holding the offset of every chunk's record, 0 for chunks that were never saved, followed by the records in the order
+// they were written. Depending on the storage, a record is either all of the chunk's tiles, or a u32 edit count
+// followed by the edits. Saving a chunk again writes over its old record when the new one fits, otherwise it appends
+// a new record and points the entry at it, after the record is written. Chunks in the batch being written are loaded
+// from the batch, so a reader that has the file mapped never sees a record it reads change under it, and never sees
+// an entry pointing at a record that isn't there yet.
+//
+// Files are mapped and read on the main thread. Saves are collected into a batch, which is written on the low
+// priority queue while the next one fills up. Mappings of the regions a batch touched are dropped once it's written,
+// and mapped again, grown, the next time they're needed.
+//
+// The header counts the bytes of records that were replaced or cleared. Once they're more than the live records take
+// up, the file is compacted on the main thread after the batch, while nothing has it mapped and the writer is idle.
+#define RegionDim 32
+#define RegionChunkCount (RegionDim * RegionDim)
+#define RegionFileMagic 0x4E474552 // "REGN"
+#define RegionFileVersion 4
+#define RegionCacheCount 64
+#define RegionWriteBatchMaxCount 256
+// NOTE: Smaller files aren't worth compacting, however much of them is dead
+#define RegionCompactMinDeadBytes Kilobytes(64)
+
+enum region_storage
+{
+    // NOTE: Every tile of every chunk that was ever dropped, so loading a chunk never evaluates noise
+    RegionStorage_Tiles,
+    // NOTE: Only tiles that differ from what the generator makes, chunks nobody changed aren't stored at all. Loading
+    // generates the chunk again and applies the edits on top.
+    RegionStorage_Edits,
+};
+
+struct region_tile_edit
+{
+    u16 TileIndex;
+    u16 Tile;
+};
+
+struct region_file_header
+{
+    u32 Magic;
+    u32 Version;
+    u32 TilesPerChunk;
+    // NOTE: A region_storage, a file is only ever read and written with the storage it was created with
+    u32 Storage;
+    // NOTE: The world_generator Seed and WorldGeneratorVersion the file was made with, it's only good for that terrain
+    u64 Seed;
+    u32 GeneratorVersion;
+    // NOTE: Taken up by records nothing points at anymore, or by the end of records that were written over by
+    // smaller ones
+    u32 DeadBytes;
+    u32 ChunkOffsets[RegionChunkCount];
+};
+
+struct mapped_region
+{
+    b32 IsUsed;
+    vec3i P;
+    // NOTE: Data is 0 when the region has no file yet
+    platform_mapped_file File;
+};
+
+struct region_write
+{
+    vec3i ChunkP;
+    u16 Tiles[ChunkTileCount];
+};
+
+struct region_store;
+
+struct region_write_batch
+{
+    region_store *Store;
+    u32 Count;
+    region_write Writes[RegionWriteBatchMaxCount];
+    // NOTE: Set by the writer, regions to compact once the batch is done
+    u32 CompactCount;
+    vec3i CompactRegionPs[RegionWriteBatchMaxCount];
+    // NOTE: Set by the writer once the whole batch is on disk
+    b32 volatile IsDone;
+};
+
+struct region_store
+{
+    simple_string Directory;
+    region_storage Storage;
+    // NOTE: Only read, from whichever thread writes, to work out the edits
+    world_generator *Generator;
+    // NOTE: 0 to write on the main thread instead
+    platform_work_queue *WorkQueue;
+
+    mapped_region Regions[RegionCacheCount];
+    u32 NextRegionSlot;
+
+    region_write_batch Batches[2];
+    region_write_batch *Pending;
+    // NOTE: Owned by the writer, 0 when it's idle
+    region_write_batch *Writing;
+
+    u32 LoadedCount;
+    u32 SavedCount;
+};
+
+// NOTE: Chunks dropped from the store, kept compressed in memory so they come back without touching a region file or
+// the generator. The distinct tile ids of a chunk go into a palette, and every tile becomes the index of its id in it,
+// packed with as few bits as the palette needs. Chunks with more ids than that saves anything on are kept as they are.
+//
+// Entries sit in a ring buffer of BudgetBytes, a header followed by the palette and the packed indices, each taking a
+// multiple of ColdChunkAlignment. New entries go after the newest one, dropping the oldest ones to make room, so the
+// cold chunks that go are the ones that went cold longest ago. Taking a chunk out only removes it from the index, its
+// bytes are reclaimed once the oldest entry catches up with them. An entry is live while the index points at it.
+//
+// The index is open addressing like the chunk table, only without growing. It's sized for BudgetBytes worth of
+// entries of ColdChunkExpectedSize, and oldest entries are dropped as well when it's full.
+#define ColdChunkAlignment 16
+#define ColdChunkExpectedSize 64
+
+struct cold_chunk_header
+{
+    vec3i P;
+    // NOTE: Including the header and the padding at the end
+    u16 Size;
+    // NOTE: 0 when the tiles are stored as they are
+    u16 PaletteCount;
+};
+
+struct cold_chunk_index_entry
+{
+    vec3i P;
+    // NOTE: Offset of the entry in the ring plus one, 0 when the index entry is empty
+    u32 OffsetPlusOne;
+};
+
+struct cold_chunk_store
+{
+    u32 BudgetBytes;
+    u8 *Ring;
+    // NOTE: Where the oldest entry starts and where the next one goes. UsedBytes tells a full ring from an empty one
+    // when they're equal.
+    u32 OldestOffset;
+    u32 NextOffset;
+    u32 UsedBytes;
+
+    u32 IndexCapacity;
+    u32 MaxCount;
+    u32 Count;
+    cold_chunk_index_entry *Index;
+
+    // NOTE: Bytes taken up by the live entries, against ChunkTileCount u16s each uncompressed
+    u32 LiveBytes;
+
+    u32 HitCount;
+    u32 MissCount;
+    u32 DroppedCount;
+};
+
+// NOTE: Owns every chunk. Once more than MaxResidentCount chunks are loaded, the least recently used ones further
+// than KeepRadius chunks from the camera are dropped and their memory reused for new chunks, so however far the
+// player goes the world never needs more than MaxResidentCount chunks (plus whatever is in use in a single frame).
+struct chunk_store
+{
+    memory_arena *Arena;
+    chunk_table Table;
+
+    u32 MaxResidentCount;
+    i32 KeepRadius;
+
+    u64 Frame;
+    chunk *MostRecentlyUsed;
+    chunk *LeastRecentlyUsed;
+    chunk *FreeList;
+    // NOTE: Where chunks are saved to when they're dropped, and loaded from before generating them. Optional.
+    region_store *Regions;
+    // NOTE: Where dropped chunks go after they're saved, and are looked for first. Optional.
+    cold_chunk_store *Cold;
+
+    u32 ResidentCount;
+    u32 FreeCount;
+    u32 EvictedCount;
+};
+
+// NOTE: A tile position that remembers its chunk, so moving to a tile nearby follows a neighbour link instead of
+// looking the chunk up. Only good for the frame it was made in, since chunks are evicted at the end of it.
+struct tile_cursor
+{
+    chunk_store *Store;
+    vec3i ChunkDim;
+
+    vec3i TileP;
+    vec3i ChunkP;
+    // NOTE: 0 when the chunk isn't resident
+    chunk *Chunk;
+    // NOTE: TileP within the chunk
+    i32 X;
+    i32 Y;
+};
+
+// NOTE: Requested chunks go into the store straight away, still ChunkState_Generating, and wait in the backlog. Every
+// frame the backlog is sorted so the chunks nearest the camera go first.
+//
+// With a work queue, they are handed to jobs on it. A worker fills in the tiles and puts the job on the completion
+// ring, and the main thread publishes everything on the ring at the start of the next frame. Without one, the main
+// thread generates them itself, a row at a time until the frame's budget is spent, picking up a half done chunk where
+// it left off on the next frame.
+//
+// The completion ring has a slot for every job, so a worker reserving a slot with an atomic add always gets an empty
+// one. It then stores the job pointer into it, which is what the main thread waits for, in slot order.
+#define ChunkGenerationMaxJobCount 128
+#define ChunkGenerationMaxBacklogCount 256
+
+struct chunk_generation_queue;
+
+struct chunk_generation_job
+{
+    chunk_generation_queue *Queue;
+    chunk *Chunk;
+    // NOTE: How long the worker took, written before the job is completed
+    f64 Seconds;
+};
+
+struct chunk_generation_queue
+{
+    world_generator *Generator;
+    chunk_store *Store;
+    // NOTE: 0 to generate on the main thread instead
+    platform_work_queue *WorkQueue;
+
+    chunk_generation_job Jobs[ChunkGenerationMaxJobCount];
+    chunk_generation_job *FreeJobs[ChunkGenerationMaxJobCount];
+    u32 FreeJobCount;
+
+    u32 BacklogCount;
+    // NOTE: Nearest to the camera last, so the next chunk pops off the end
+    chunk *Backlog[ChunkGenerationMaxBacklogCount];
+
+    // NOTE: The chunk the main thread is part way through, and the first row it hasn't generated
+    chunk *PartialChunk;
+    i32 PartialNextRow;
+    random_state PartialRandom;
+    f64 PartialStartSeconds;
+
+    chunk_generation_job *volatile Completed[ChunkGenerationMaxJobCount];
+    u32 volatile CompletedWriteIndex;
+    u32 CompletedReadIndex;
+
+    u32 InFlightCount;
+    u32 GeneratedCount;
+    // NOTE: Wall clock time from starting a chunk to finishing it, averaged over the last few. On the main thread
+    // that's spread over several frames, so it includes the frames in between.
+    f64 SecondsPerChunk;
+};
+
+// NOTE: Guesses where the player is headed from how they moved lately, so the chunks there get generated before they
+// come into view. The rect is grown ahead of the player by as many chunks as they cross while the chunks along one
+// edge of the view get generated.
+#define PrefetchMaxDepth 4
+#define PrefetchVelocitySmoothingSeconds 0.5f
+#define PrefetchMinSpeed 1.0f
+
+struct chunk_prefetcher
+{
+    // NOTE: Tiles per second
+    vec2 Velocity;
+
+    // NOTE: Chunks that came into view, and how many of those were already generated by then
+    b32 HasLastView;
+    vec3i LastViewMin;
+    vec3i LastViewMax;
+    u32 NewlyVisibleCount;
+    u32 HitCount;
+};
+
+// NOTE: A picture of the terrain around the origin, saved as BMPs of the continental noise, the terrain noise and the
+// tiles they make. Drawn in squares of WorldPreviewTileDim pixels on the low priority queue, no more than
+// WorldPreviewMaxJobCount of them queued at a time so chunk generation never waits long behind it, and whoever
+// finishes the last square saves the images. The files are named after a hash of everything that goes into them, so
+// a preview that's on disk already isn't drawn again.
+#define WorldPreviewRadius 512
+#define WorldPreviewTileDim 64
+#define WorldPreviewMaxJobCount 16
+// NOTE: Part of the hash, for when the way the preview is drawn changes
+#define WorldPreviewVersion 1
+
+struct world_preview
+{
+    world_generator *Generator;
+    // NOTE: 0 to draw on the main thread instead, a square a frame
+    platform_work_queue *WorkQueue;
+
+    u64 Key;
+    i32 MinX;
+    i32 MinY;
+    // NOTE: ImageData is 0 until the first preview is drawn
+    platform_image ContinentalImage;
+    platform_image TerrainImage;
+    platform_image MapImage;
+
+    b32 IsRunning;
+    f64 StartSeconds;
+    u32 TileCountX;
+    u32 TileCount;
+    u32 QueuedTileCount;
+    // NOTE: Every job draws whichever square is next, so jobs don't need anything of their own
+    u32 volatile NextTileIndex;
+    u32 volatile CompletedTileCount;
+    // NOTE: Set once the images are saved
+    b32 volatile IsDone;
+};
+
+#endif
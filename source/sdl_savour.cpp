@@ -4,6 +4,18 @@
 
 #include <sdl2/SDL.h>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "and_common.h"
 #include "and_math.h"
 #include "and_linmath.h"
@@ -12,6 +24,28 @@
 
 internal void UpdateInput(SDL_Renderer *Render, game_input *GameInput);
 
+struct platform_work_queue_entry
+{
+    platform_work_queue_callback *Callback;
+    void *Data;
+};
+
+struct platform_work_queue
+{
+    SDL_atomic_t CompletionGoal;
+    SDL_atomic_t CompletionCount;
+
+    SDL_atomic_t NextEntryToWrite;
+    SDL_atomic_t NextEntryToRead;
+    SDL_sem *Semaphore;
+    SDL_ThreadPriority ThreadPriority;
+
+    platform_work_queue_entry Entries[256];
+};
+
+internal void MakeWorkQueue(platform_work_queue *Queue, u32 ThreadCount, SDL_ThreadPriority ThreadPriority);
+internal SDL_Texture *CreateOffscreenTexture(SDL_Renderer *Renderer, platform_image *OffscreenBuffer);
+
 int main(int argc, char **argv)
 {
     i32 SDLInitResult = SDL_Init(SDL_INIT_VIDEO);
@@ -30,28 +64,42 @@ int main(int argc, char **argv)
     SDL_Renderer *Renderer = SDL_CreateRenderer(Window, -1, SDL_RENDERER_PRESENTVSYNC);
     Assert(Renderer);
     
+    // NOTE: The game draws into a buffer of our own that keeps what it drew last frame, and only the parts it
+    // changed get copied into the texture
     platform_image OffscreenBuffer = {};
     OffscreenBuffer.Width = ClientWidth;
     OffscreenBuffer.Height = ClientHeight;
-    u32 BytesPerPixel = 4;
-    OffscreenBuffer.ImageData = calloc(1, OffscreenBuffer.Width * OffscreenBuffer.Height * BytesPerPixel);
+    OffscreenBuffer.Pitch = OffscreenBuffer.Width * 4;
+    OffscreenBuffer.ImageData = calloc(1, (size_t) OffscreenBuffer.Pitch * OffscreenBuffer.Height);
     Assert(OffscreenBuffer.ImageData);
+    OffscreenBuffer.ContentsLost = true;
     
     SDL_SetWindowMinimumSize(Window, OffscreenBuffer.Width, OffscreenBuffer.Height);
     SDL_RenderSetLogicalSize(Renderer, OffscreenBuffer.Width, OffscreenBuffer.Height);
-    SDL_Texture *OffscreenTexture = SDL_CreateTexture(Renderer,
-                                                      SDL_PIXELFORMAT_RGBA8888,
-                                                      SDL_TEXTUREACCESS_STREAMING,
-                                                      OffscreenBuffer.Width,
-                                                      OffscreenBuffer.Height);
+    SDL_Texture *OffscreenTexture = CreateOffscreenTexture(Renderer, &OffscreenBuffer);
     Assert(OffscreenTexture);
+    // NOTE: Set when the texture doesn't match the buffer, after it was made or an upload failed
+    b32 ShouldUploadAll = true;
 
     game_input *GameInput = (game_input *) calloc(1, sizeof(game_input));
      // TODO: Maybe these 2 should be set and stored elsewhere
     GameInput->KeyRepeatDelay_ = 0.2f;
     GameInput->KeyRepeatPeriod_ = 0.09f;
     game_memory GameMemory = {};
-    GameMemory.StorageSize = Megabytes(128);
+
+    // NOTE: One worker per logical core, the main thread takes the last one while waiting on the queue
+    platform_work_queue HighPriorityQueue = {};
+    i32 CPUCount = SDL_GetCPUCount();
+    GameMemory.WorkerThreadCount = (CPUCount > 1) ? (u32) (CPUCount - 1) : 0;
+    MakeWorkQueue(&HighPriorityQueue, GameMemory.WorkerThreadCount, SDL_THREAD_PRIORITY_NORMAL);
+    GameMemory.HighPriorityQueue = &HighPriorityQueue;
+
+    // NOTE: A couple of low priority threads for background work, they get the time the rest of the frame leaves
+    platform_work_queue LowPriorityQueue = {};
+    MakeWorkQueue(&LowPriorityQueue, 2, SDL_THREAD_PRIORITY_LOW);
+    GameMemory.LowPriorityQueue = &LowPriorityQueue;
+
+    GameMemory.StorageSize = Megabytes(256);
     GameMemory.Storage = calloc(1, GameMemory.StorageSize);
     Assert(GameMemory.Storage);
 
@@ -68,9 +116,25 @@ int main(int argc, char **argv)
         {
             switch (Event.type)
             {
+                // NOTE: The game gets a frame to save everything, it sets ShouldQuit when it's done
                 case SDL_QUIT:
                 {
-                    ShouldQuit = true;
+                    GameInput->QuitRequested = true;
+                } break;
+
+                // NOTE: Our buffer still has the frame, only what's on the GPU side is gone. After a device reset
+                // the textures themselves have to be made again.
+                case SDL_RENDER_TARGETS_RESET:
+                {
+                    ShouldUploadAll = true;
+                } break;
+
+                case SDL_RENDER_DEVICE_RESET:
+                {
+                    SDL_DestroyTexture(OffscreenTexture);
+                    OffscreenTexture = CreateOffscreenTexture(Renderer, &OffscreenBuffer);
+                    Assert(OffscreenTexture);
+                    ShouldUploadAll = true;
                 } break;
             }
         }
@@ -84,24 +148,54 @@ int main(int argc, char **argv)
         //
         // NOTE: Run game
         //
+        OffscreenBuffer.DirtyRectCount = 0;
         GameUpdateAndRender(GameInput, &GameMemory, &OffscreenBuffer, &ShouldQuit);
+        OffscreenBuffer.ContentsLost = false;
+
+        //
+        // NOTE: Upload what changed
+        //
+        if (ShouldUploadAll)
+        {
+            if (SDL_UpdateTexture(OffscreenTexture, NULL, OffscreenBuffer.ImageData, OffscreenBuffer.Pitch) == 0)
+            {
+                ShouldUploadAll = false;
+            }
+            else
+            {
+                printf("SDL: Error when updating texture: %s\n", SDL_GetError());
+            }
+        }
+        else
+        {
+            for (u32 RectI = 0;
+                 RectI < OffscreenBuffer.DirtyRectCount;
+                 ++RectI)
+            {
+                platform_rect *Dirty = OffscreenBuffer.DirtyRects + RectI;
+                SDL_Rect Rect = {Dirty->X, Dirty->Y, Dirty->Width, Dirty->Height};
+                u8 *Pixels = (u8 *) OffscreenBuffer.ImageData + Dirty->Y * OffscreenBuffer.Pitch + Dirty->X * 4;
+                if (SDL_UpdateTexture(OffscreenTexture, &Rect, Pixels, OffscreenBuffer.Pitch) != 0)
+                {
+                    // NOTE: The texture is behind the buffer now, send all of it next time
+                    printf("SDL: Error when updating texture: %s\n", SDL_GetError());
+                    ShouldUploadAll = true;
+                    break;
+                }
+            }
+        }
 
         //
         // NOTE: Flip buffer
         //
-        SDL_RenderClear(Renderer);
-        SDL_UpdateTexture(OffscreenTexture, NULL, OffscreenBuffer.ImageData, OffscreenBuffer.Width * BytesPerPixel);
-        // TODO INVESTIGATE: is there double double buffer? We're copying, and then "presenting"
-        SDL_RenderCopy(Renderer, OffscreenTexture, NULL, NULL);
-        SDL_RenderPresent(Renderer);
-        // NOTE: Clear offscreen buffer
-        // TODO: Move to game
-        u32 *Pixel = (u32 *) OffscreenBuffer.ImageData;
-        for (i32 PixelIndex = 0;
-             PixelIndex < OffscreenBuffer.Width * OffscreenBuffer.Height;
-             ++PixelIndex)
+        // NOTE: When an upload failed the texture is half old and half new, so this frame is skipped and the last
+        // one stays on screen
+        if (!ShouldUploadAll)
         {
-            *Pixel++ = 0xFF0000FF;
+            // NOTE: The clear only covers the letterbox bars around the texture when the window is resized
+            SDL_RenderClear(Renderer);
+            SDL_RenderCopy(Renderer, OffscreenTexture, NULL, NULL);
+            SDL_RenderPresent(Renderer);
         }
 
         //
@@ -113,11 +207,15 @@ int main(int argc, char **argv)
         PrevFrameDeltaTimeSec = (f64) CounterElapsed / (f64) PerfCounterFrequency;
         FPS = 1.0 / PrevFrameDeltaTimeSec;
 
-        char Title[256];
-        sprintf_s(Title, "Savour [%0.3fFPS|%0.3fms]", FPS, PrevFrameDeltaTimeSec * 1000.0);
+        char Title[512];
+        sprintf_s(Title, "Savour [%0.3fFPS|%0.3fms] %s", FPS, PrevFrameDeltaTimeSec * 1000.0, GameMemory.PerfStatus.D);
         SDL_SetWindowTitle(Window, Title);
     }
 
+    // NOTE: Background work may still be using game memory or have files open
+    Platform_CompleteAllWork(&LowPriorityQueue);
+    Platform_CompleteAllWork(&HighPriorityQueue);
+
     SDL_DestroyWindow(Window);
 
     SDL_Quit();
@@ -125,6 +223,109 @@ int main(int argc, char **argv)
     return 0;
 }
 
+//
+// NOTE: Work queue
+//
+
+void
+Platform_AddWorkEntry(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data)
+{
+    u32 EntryIndex = (u32) SDL_AtomicGet(&Queue->NextEntryToWrite);
+    u32 NewNextEntryToWrite = (EntryIndex + 1) % ArrayCount(Queue->Entries);
+    Assert(NewNextEntryToWrite != (u32) SDL_AtomicGet(&Queue->NextEntryToRead));
+
+    platform_work_queue_entry *Entry = Queue->Entries + EntryIndex;
+    Entry->Callback = Callback;
+    Entry->Data = Data;
+    SDL_AtomicIncRef(&Queue->CompletionGoal);
+
+    // NOTE: The entry has to be visible before the workers can see the new write index
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&Queue->NextEntryToWrite, (i32) NewNextEntryToWrite);
+    SDL_SemPost(Queue->Semaphore);
+}
+
+// NOTE: Returns true if there was nothing to do
+internal b32
+DoNextWorkQueueEntry(platform_work_queue *Queue)
+{
+    b32 ShouldSleep = false;
+
+    u32 OriginalNextEntryToRead = (u32) SDL_AtomicGet(&Queue->NextEntryToRead);
+    u32 NewNextEntryToRead = (OriginalNextEntryToRead + 1) % ArrayCount(Queue->Entries);
+    if (OriginalNextEntryToRead != (u32) SDL_AtomicGet(&Queue->NextEntryToWrite))
+    {
+        if (SDL_AtomicCAS(&Queue->NextEntryToRead, (i32) OriginalNextEntryToRead, (i32) NewNextEntryToRead))
+        {
+            SDL_MemoryBarrierAcquire();
+            platform_work_queue_entry Entry = Queue->Entries[OriginalNextEntryToRead];
+            Entry.Callback(Queue, Entry.Data);
+            SDL_AtomicIncRef(&Queue->CompletionCount);
+        }
+    }
+    else
+    {
+        ShouldSleep = true;
+    }
+
+    return ShouldSleep;
+}
+
+void
+Platform_CompleteAllWork(platform_work_queue *Queue)
+{
+    while (SDL_AtomicGet(&Queue->CompletionGoal) != SDL_AtomicGet(&Queue->CompletionCount))
+    {
+        DoNextWorkQueueEntry(Queue);
+    }
+
+    SDL_AtomicSet(&Queue->CompletionGoal, 0);
+    SDL_AtomicSet(&Queue->CompletionCount, 0);
+}
+
+internal int
+WorkerThreadProc(void *Data)
+{
+    platform_work_queue *Queue = (platform_work_queue *) Data;
+    SDL_SetThreadPriority(Queue->ThreadPriority);
+
+    for (;;)
+    {
+        if (DoNextWorkQueueEntry(Queue))
+        {
+            SDL_SemWait(Queue->Semaphore);
+        }
+    }
+}
+
+internal void
+MakeWorkQueue(platform_work_queue *Queue, u32 ThreadCount, SDL_ThreadPriority ThreadPriority)
+{
+    Queue->Semaphore = SDL_CreateSemaphore(0);
+    Assert(Queue->Semaphore);
+    Queue->ThreadPriority = ThreadPriority;
+
+    for (u32 ThreadIndex = 0;
+         ThreadIndex < ThreadCount;
+         ++ThreadIndex)
+    {
+        SDL_Thread *Thread = SDL_CreateThread(WorkerThreadProc, "Worker", Queue);
+        Assert(Thread);
+        SDL_DetachThread(Thread);
+    }
+}
+
+internal SDL_Texture *
+CreateOffscreenTexture(SDL_Renderer *Renderer, platform_image *OffscreenBuffer)
+{
+    SDL_Texture *Result = SDL_CreateTexture(Renderer,
+                                            SDL_PIXELFORMAT_RGBA8888,
+                                            SDL_TEXTUREACCESS_STREAMING,
+                                            OffscreenBuffer->Width,
+                                            OffscreenBuffer->Height);
+    return Result;
+}
+
 internal void
 UpdateInput(SDL_Renderer *Renderer, game_input *GameInput)
 {
@@ -173,6 +374,7 @@ Platform_LoadBMP(const char *Path)
 
     Result.Width = RGBASurface->w;
     Result.Height = RGBASurface->h;
+    Result.Pitch = RGBASurface->pitch;
     Result.ImageData = RGBASurface->pixels;
     Result.PointerToFree_ = (void *) RGBASurface;
     
@@ -194,11 +396,18 @@ Platform_SaveRGBA_BMP(platform_image *PlatformImage, const char *Name, b32 Times
                                                               PlatformImage->Width,
                                                               PlatformImage->Height,
                                                               32, // depth in bits
-                                                              PlatformImage->Width * 4, // pitch in bytes
+                                                              PlatformImage->Pitch, // pitch in bytes
                                                               0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF);
 
     char Path[256];
-    sprintf_s(Path, "temp/%s%lld.bmp", Name, time(NULL));
+    if (Timestamp)
+    {
+        sprintf_s(Path, "temp/%s%lld.bmp", Name, time(NULL));
+    }
+    else
+    {
+        sprintf_s(Path, "temp/%s.bmp", Name);
+    }
     i32 Result = SDL_SaveBMP(TestPerlinSurface, Path);
     if (Result != 0)
     {
@@ -207,3 +416,258 @@ Platform_SaveRGBA_BMP(platform_image *PlatformImage, const char *Name, b32 Times
 
     SDL_FreeSurface(TestPerlinSurface);
 }
+
+b32
+Platform_HasSSE2()
+{
+    b32 Result = SDL_HasSSE2();
+    return Result;
+}
+
+b32
+Platform_HasAVX2()
+{
+    b32 Result = SDL_HasAVX2();
+    return Result;
+}
+
+f64
+Platform_GetSeconds()
+{
+    f64 Result = (f64) SDL_GetPerformanceCounter() / (f64) SDL_GetPerformanceFrequency();
+    return Result;
+}
+
+#if defined(_WIN32)
+platform_mapped_file
+Platform_MapFile(const char *Path)
+{
+    platform_mapped_file Result = {};
+
+    HANDLE File = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (File != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER FileSize;
+        if (GetFileSizeEx(File, &FileSize) && FileSize.QuadPart > 0)
+        {
+            // NOTE: The view keeps the mapping and the file alive, neither handle is needed after this
+            HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_READONLY, 0, 0, 0);
+            if (Mapping)
+            {
+                Result.Data = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+                if (Result.Data)
+                {
+                    Result.Size = (u64) FileSize.QuadPart;
+                }
+                CloseHandle(Mapping);
+            }
+        }
+        CloseHandle(File);
+    }
+
+    return Result;
+}
+
+void
+Platform_UnmapFile(platform_mapped_file *MappedFile)
+{
+    if (MappedFile->Data)
+    {
+        UnmapViewOfFile(MappedFile->Data);
+    }
+    MappedFile->Data = 0;
+    MappedFile->Size = 0;
+}
+
+platform_file
+Platform_OpenFile(const char *Path)
+{
+    platform_file Result = {};
+
+    HANDLE File = CreateFileA(Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    LARGE_INTEGER FileSize;
+    if (File != INVALID_HANDLE_VALUE && GetFileSizeEx(File, &FileSize))
+    {
+        Result.IsOpen = true;
+        Result.Size = (u64) FileSize.QuadPart;
+        Result.Handle_ = (void *) File;
+    }
+    else
+    {
+        printf("Platform: Can't open %s\n", Path);
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(File);
+        }
+    }
+
+    return Result;
+}
+
+b32
+Platform_ReadFile(platform_file *File, u64 Offset, void *Data, u32 Size)
+{
+    OVERLAPPED Overlapped = {};
+    Overlapped.Offset = (u32) Offset;
+    Overlapped.OffsetHigh = (u32) (Offset >> 32);
+
+    DWORD BytesRead = 0;
+    b32 Result = ReadFile((HANDLE) File->Handle_, Data, Size, &BytesRead, &Overlapped) && BytesRead == Size;
+    return Result;
+}
+
+b32
+Platform_WriteFile(platform_file *File, u64 Offset, void *Data, u32 Size)
+{
+    OVERLAPPED Overlapped = {};
+    Overlapped.Offset = (u32) Offset;
+    Overlapped.OffsetHigh = (u32) (Offset >> 32);
+
+    DWORD BytesWritten = 0;
+    b32 Result = WriteFile((HANDLE) File->Handle_, Data, Size, &BytesWritten, &Overlapped) && BytesWritten == Size;
+    if (Result && Offset + Size > File->Size)
+    {
+        File->Size = Offset + Size;
+    }
+    return Result;
+}
+
+b32
+Platform_SetFileSize(platform_file *File, u64 Size)
+{
+    LARGE_INTEGER NewSize;
+    NewSize.QuadPart = (LONGLONG) Size;
+    b32 Result = (SetFilePointerEx((HANDLE) File->Handle_, NewSize, 0, FILE_BEGIN) &&
+                  SetEndOfFile((HANDLE) File->Handle_));
+    if (Result)
+    {
+        File->Size = Size;
+    }
+    return Result;
+}
+
+void
+Platform_CloseFile(platform_file *File)
+{
+    if (File->IsOpen)
+    {
+        CloseHandle((HANDLE) File->Handle_);
+    }
+    *File = {};
+}
+
+b32
+Platform_CreateDirectory(const char *Path)
+{
+    b32 Result = (CreateDirectoryA(Path, 0) || GetLastError() == ERROR_ALREADY_EXISTS);
+    return Result;
+}
+#else
+platform_mapped_file
+Platform_MapFile(const char *Path)
+{
+    platform_mapped_file Result = {};
+
+    int File = open(Path, O_RDONLY);
+    if (File >= 0)
+    {
+        struct stat FileStat;
+        if (fstat(File, &FileStat) == 0 && FileStat.st_size > 0)
+        {
+            void *Data = mmap(0, (size_t) FileStat.st_size, PROT_READ, MAP_SHARED, File, 0);
+            if (Data != MAP_FAILED)
+            {
+                Result.Data = Data;
+                Result.Size = (u64) FileStat.st_size;
+            }
+        }
+        close(File);
+    }
+
+    return Result;
+}
+
+void
+Platform_UnmapFile(platform_mapped_file *MappedFile)
+{
+    if (MappedFile->Data)
+    {
+        munmap(MappedFile->Data, (size_t) MappedFile->Size);
+    }
+    MappedFile->Data = 0;
+    MappedFile->Size = 0;
+}
+
+platform_file
+Platform_OpenFile(const char *Path)
+{
+    platform_file Result = {};
+
+    int File = open(Path, O_RDWR | O_CREAT, 0644);
+    struct stat FileStat;
+    if (File >= 0 && fstat(File, &FileStat) == 0)
+    {
+        Result.IsOpen = true;
+        Result.Size = (u64) FileStat.st_size;
+        Result.Handle_ = (void *) (intptr_t) File;
+    }
+    else
+    {
+        printf("Platform: Can't open %s\n", Path);
+        if (File >= 0)
+        {
+            close(File);
+        }
+    }
+
+    return Result;
+}
+
+b32
+Platform_ReadFile(platform_file *File, u64 Offset, void *Data, u32 Size)
+{
+    b32 Result = pread((int) (intptr_t) File->Handle_, Data, Size, (off_t) Offset) == (ssize_t) Size;
+    return Result;
+}
+
+b32
+Platform_WriteFile(platform_file *File, u64 Offset, void *Data, u32 Size)
+{
+    b32 Result = pwrite((int) (intptr_t) File->Handle_, Data, Size, (off_t) Offset) == (ssize_t) Size;
+    if (Result && Offset + Size > File->Size)
+    {
+        File->Size = Offset + Size;
+    }
+    return Result;
+}
+
+b32
+Platform_SetFileSize(platform_file *File, u64 Size)
+{
+    b32 Result = (ftruncate((int) (intptr_t) File->Handle_, (off_t) Size) == 0);
+    if (Result)
+    {
+        File->Size = Size;
+    }
+    return Result;
+}
+
+void
+Platform_CloseFile(platform_file *File)
+{
+    if (File->IsOpen)
+    {
+        close((int) (intptr_t) File->Handle_);
+    }
+    *File = {};
+}
+
+b32
+Platform_CreateDirectory(const char *Path)
+{
+    b32 Result = (mkdir(Path, 0755) == 0 || errno == EEXIST);
+    return Result;
+}
+#endif